@@ -0,0 +1,90 @@
+#ifndef _BOUNDED_QUEUE_H_
+#define _BOUNDED_QUEUE_H_
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+// blocking FIFO queue with limited capacity, producers wait when it is full and consumers wait when it is empty
+template <class T>
+class CBoundedQueue
+{
+private:
+	const size_t capacity;
+	bool closed;
+	std::deque<T> items;
+
+	mutable std::mutex guard;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+
+public:
+	// returns false if the queue was closed
+	bool push(T&& item)
+	{
+		std::unique_lock<std::mutex> lock(guard);
+		not_full.wait(lock, [this] { return closed || items.size() < capacity; });
+
+		if (closed)
+			return false;
+
+		items.push_back(std::move(item));
+		not_empty.notify_one();
+		return true;
+	}
+
+	// returns false once the queue is closed and empty
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(guard);
+		not_empty.wait(lock, [this] { return closed || !items.empty(); });
+
+		if (items.empty())
+			return false;
+
+		item = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	}
+
+	// waits for at least one item and then takes up to max_items that are already queued, returns false once the queue is closed and empty
+	bool pop_batch(std::vector<T>& batch, size_t max_items)
+	{
+		std::unique_lock<std::mutex> lock(guard);
+		not_empty.wait(lock, [this] { return closed || !items.empty(); });
+
+		if (items.empty())
+			return false;
+
+		while (!items.empty() && batch.size() < max_items)
+		{
+			batch.push_back(std::move(items.front()));
+			items.pop_front();
+		}
+
+		not_full.notify_all();
+		return true;
+	}
+
+	// wakes up everyone waiting, remaining items can still be popped
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		closed = true;
+		not_empty.notify_all();
+		not_full.notify_all();
+	}
+
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		return items.size();
+	}
+
+	CBoundedQueue(size_t capacity) : capacity(capacity), closed(false)
+	{
+	}
+};
+#endif // !_BOUNDED_QUEUE_H_
@@ -0,0 +1,318 @@
+#include <cstring>
+#include <stdexcept>
+
+#ifdef MATRIX_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef MATRIX_WITH_LZMA
+#include <lzma.h>
+#endif
+
+#ifdef MATRIX_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "CompressedInput.h"
+
+const char* get_input_compression_name(input_compression compression)
+{
+	switch (compression)
+	{
+	case input_compression::none: return "none";
+	case input_compression::gzip: return "gzip";
+	case input_compression::xz: return "xz";
+	case input_compression::zstd: return "zstd";
+	}
+
+	return "unknown";
+}
+
+input_compression detect_input_compression(std::istream& stream)
+{
+	static const unsigned char gzip_magic[] = { 0x1f, 0x8b };
+	static const unsigned char xz_magic[] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+	static const unsigned char zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+	unsigned char magic[sizeof(xz_magic)] = {};
+	const std::streampos start = stream.tellg();
+	stream.read((char*)magic, sizeof(magic));
+	const size_t read = (size_t)stream.gcount();
+
+	stream.clear();
+	stream.seekg(start);
+
+	if (read >= sizeof(gzip_magic) && std::memcmp(magic, gzip_magic, sizeof(gzip_magic)) == 0)
+		return input_compression::gzip;
+
+	if (read >= sizeof(xz_magic) && std::memcmp(magic, xz_magic, sizeof(xz_magic)) == 0)
+		return input_compression::xz;
+
+	if (read >= sizeof(zstd_magic) && std::memcmp(magic, zstd_magic, sizeof(zstd_magic)) == 0)
+		return input_compression::zstd;
+
+	return input_compression::none;
+}
+
+CDecompressingStreamBuffer::CDecompressingStreamBuffer(std::istream& source, input_compression compression)
+	:
+	source(source),
+	compression(compression),
+	chunks(DECOMPRESSION_QUEUE_CAPACITY)
+{
+	setg(nullptr, nullptr, nullptr);
+	decompressor_thread = std::thread(&CDecompressingStreamBuffer::decompress, this);
+}
+
+CDecompressingStreamBuffer::~CDecompressingStreamBuffer()
+{
+	// decompressor waiting for free space gets refused and stops
+	chunks.close();
+
+	if (decompressor_thread.joinable())
+		decompressor_thread.join();
+}
+
+bool CDecompressingStreamBuffer::emit(const char* data, size_t size)
+{
+	return size == 0 || chunks.push(std::vector<char>(data, data + size));
+}
+
+void CDecompressingStreamBuffer::decompress()
+{
+	try
+	{
+		switch (compression)
+		{
+		case input_compression::gzip:
+			decompress_gzip();
+			break;
+
+		case input_compression::xz:
+			decompress_xz();
+			break;
+
+		case input_compression::zstd:
+			decompress_zstd();
+			break;
+
+		case input_compression::none:
+		{
+			std::vector<char> input(DECOMPRESSION_CHUNK_SIZE);
+
+			while (source.read(input.data(), input.size()) || source.gcount() > 0)
+				if (!emit(input.data(), (size_t)source.gcount()))
+					break;
+			break;
+		}
+		}
+	}
+	catch (...)
+	{
+		decompression_error = std::current_exception();
+	}
+
+	// the error is published by closing the queue, underflow reads it only after that
+	chunks.close();
+}
+
+void CDecompressingStreamBuffer::decompress_gzip()
+{
+#ifdef MATRIX_WITH_ZLIB
+	z_stream stream;
+	std::memset(&stream, 0, sizeof(stream));
+
+	// 15 + 32 - largest window and automatic gzip / zlib header detection
+	if (inflateInit2(&stream, 15 + 32) != Z_OK)
+		throw std::runtime_error("cannot initialize gzip decompression");
+
+	std::vector<char> input(DECOMPRESSION_CHUNK_SIZE);
+	std::vector<char> output(DECOMPRESSION_CHUNK_SIZE);
+	int status = Z_OK;
+	bool consumer_gone = false;
+
+	while (!consumer_gone)
+	{
+		if (stream.avail_in == 0)
+		{
+			source.read(input.data(), input.size());
+			stream.avail_in = (uInt)source.gcount();
+			stream.next_in = (Bytef*)input.data();
+
+			if (stream.avail_in == 0)
+				break;
+		}
+
+		stream.avail_out = (uInt)output.size();
+		stream.next_out = (Bytef*)output.data();
+		status = inflate(&stream, Z_NO_FLUSH);
+
+		if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+		{
+			inflateEnd(&stream);
+			throw std::runtime_error("corrupted gzip input");
+		}
+
+		consumer_gone = !emit(output.data(), output.size() - stream.avail_out);
+
+		// concatenated gzip members are decompressed one after another
+		if (status == Z_STREAM_END)
+			inflateReset(&stream);
+	}
+
+	inflateEnd(&stream);
+
+	if (!consumer_gone && status != Z_STREAM_END)
+		throw std::runtime_error("truncated gzip input");
+#else
+	throw std::runtime_error("gzip compressed input is not supported by this build (build with MATRIX_WITH_ZLIB)");
+#endif
+}
+
+void CDecompressingStreamBuffer::decompress_xz()
+{
+#ifdef MATRIX_WITH_LZMA
+	lzma_stream stream = LZMA_STREAM_INIT;
+
+	if (lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK)
+		throw std::runtime_error("cannot initialize xz decompression");
+
+	std::vector<char> input(DECOMPRESSION_CHUNK_SIZE);
+	std::vector<char> output(DECOMPRESSION_CHUNK_SIZE);
+	lzma_action action = LZMA_RUN;
+
+	while (true)
+	{
+		if (stream.avail_in == 0 && action == LZMA_RUN)
+		{
+			source.read(input.data(), input.size());
+			stream.avail_in = (size_t)source.gcount();
+			stream.next_in = (const uint8_t*)input.data();
+
+			if (stream.avail_in == 0)
+				action = LZMA_FINISH; // concatenated decoder needs to be told where the input ends
+		}
+
+		stream.avail_out = output.size();
+		stream.next_out = (uint8_t*)output.data();
+		const lzma_ret status = lzma_code(&stream, action);
+
+		if (status != LZMA_OK && status != LZMA_STREAM_END)
+		{
+			lzma_end(&stream);
+			throw std::runtime_error(status == LZMA_BUF_ERROR ? "truncated xz input" : "corrupted xz input");
+		}
+
+		if (!emit(output.data(), output.size() - stream.avail_out) || status == LZMA_STREAM_END)
+			break;
+	}
+
+	lzma_end(&stream);
+#else
+	throw std::runtime_error("xz compressed input is not supported by this build (build with MATRIX_WITH_LZMA)");
+#endif
+}
+
+void CDecompressingStreamBuffer::decompress_zstd()
+{
+#ifdef MATRIX_WITH_ZSTD
+	ZSTD_DStream* stream = ZSTD_createDStream();
+
+	if (!stream)
+		throw std::runtime_error("cannot initialize zstd decompression");
+
+	std::vector<char> input(DECOMPRESSION_CHUNK_SIZE);
+	std::vector<char> output(DECOMPRESSION_CHUNK_SIZE);
+	ZSTD_inBuffer input_buffer = { input.data(), 0, 0 };
+	size_t status = 0; // 0 once a frame is completely decoded
+
+	while (true)
+	{
+		if (input_buffer.pos == input_buffer.size)
+		{
+			source.read(input.data(), input.size());
+			input_buffer.size = (size_t)source.gcount();
+			input_buffer.pos = 0;
+
+			if (input_buffer.size == 0)
+				break;
+		}
+
+		ZSTD_outBuffer output_buffer = { output.data(), output.size(), 0 };
+		status = ZSTD_decompressStream(stream, &output_buffer, &input_buffer);
+
+		if (ZSTD_isError(status))
+		{
+			ZSTD_freeDStream(stream);
+			throw std::runtime_error("corrupted zstd input");
+		}
+
+		if (!emit(output.data(), output_buffer.pos))
+		{
+			status = 0;
+			break;
+		}
+	}
+
+	ZSTD_freeDStream(stream);
+
+	if (status != 0)
+		throw std::runtime_error("truncated zstd input");
+#else
+	throw std::runtime_error("zstd compressed input is not supported by this build (build with MATRIX_WITH_ZSTD)");
+#endif
+}
+
+CDecompressingStreamBuffer::int_type CDecompressingStreamBuffer::underflow()
+{
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	if (!chunks.pop(current_chunk))
+	{
+		// queue is closed at this point, so the error (if any) is already set
+		if (decompression_error)
+			std::rethrow_exception(decompression_error);
+
+		return traits_type::eof();
+	}
+
+	setg(current_chunk.data(), current_chunk.data(), current_chunk.data() + current_chunk.size());
+	return traits_type::to_int_type(*gptr());
+}
+
+CInputFile::CInputFile(const std::string& path) : file(path, std::ios::binary), compression(input_compression::none)
+{
+	if (!file.is_open())
+		throw std::runtime_error("cannot open file \"" + path + "\"");
+
+	compression = detect_input_compression(file);
+
+	if (compression == input_compression::none)
+	{
+		// plain input is read in text mode, the same as before compression support
+		file.close();
+		file.open(path);
+
+		if (!file.is_open())
+			throw std::runtime_error("cannot open file \"" + path + "\"");
+	}
+	else
+	{
+		buffer.reset(new CDecompressingStreamBuffer(file, compression));
+		decompressed_stream.reset(new std::istream(buffer.get()));
+
+		// errors thrown by the buffer are rethrown instead of just setting badbit
+		decompressed_stream->exceptions(std::ios::badbit);
+	}
+}
+
+input_compression CInputFile::get_compression() const
+{
+	return compression;
+}
+
+std::istream& CInputFile::get_stream()
+{
+	return decompressed_stream ? *decompressed_stream : file;
+}
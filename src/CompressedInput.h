@@ -0,0 +1,78 @@
+#ifndef _COMPRESSED_INPUT_H_
+#define _COMPRESSED_INPUT_H_
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <fstream>
+#include <streambuf>
+#include <memory>
+#include <thread>
+#include <exception>
+
+#include "BoundedQueue.h"
+
+// decompression libraries are optional, build with -DMATRIX_WITH_ZLIB -lz, -DMATRIX_WITH_LZMA -llzma or -DMATRIX_WITH_ZSTD -lzstd
+#define DECOMPRESSION_CHUNK_SIZE 65536
+#define DECOMPRESSION_QUEUE_CAPACITY 16 // decompressed chunks waiting for the parser
+
+enum class input_compression
+{
+	none,
+	gzip,
+	xz,
+	zstd
+};
+
+const char* get_input_compression_name(input_compression compression);
+// looks at the magic bytes at the current position, the stream is left where it was
+input_compression detect_input_compression(std::istream& stream);
+
+/*
+ * Read-only stream buffer decompressing source on its own thread. Decompressed data is handed over
+ * in chunks through a bounded queue, so decompression runs ahead of the parser by at most DECOMPRESSION_QUEUE_CAPACITY chunks.
+ * Decompression errors are thrown from underflow (after the data decompressed before the error is consumed).
+ */
+class CDecompressingStreamBuffer : public std::streambuf
+{
+private:
+	std::istream& source;
+	const input_compression compression;
+
+	CBoundedQueue<std::vector<char>> chunks;
+	std::vector<char> current_chunk;
+	std::exception_ptr decompression_error;
+	std::thread decompressor_thread;
+
+	// returns false if the consumer is gone
+	bool emit(const char* data, size_t size);
+	void decompress();
+	void decompress_gzip();
+	void decompress_xz();
+	void decompress_zstd();
+
+protected:
+	int_type underflow() override;
+
+public:
+	CDecompressingStreamBuffer(const CDecompressingStreamBuffer& original) = delete;
+	CDecompressingStreamBuffer(std::istream& source, input_compression compression);
+	~CDecompressingStreamBuffer();
+};
+
+// input file decompressed on the fly if it starts with gzip, xz or zstd magic bytes
+class CInputFile
+{
+private:
+	std::ifstream file;
+	input_compression compression;
+	std::unique_ptr<CDecompressingStreamBuffer> buffer;
+	std::unique_ptr<std::istream> decompressed_stream;
+
+public:
+	input_compression get_compression() const;
+	std::istream& get_stream();
+
+	CInputFile(const std::string& path);
+};
+#endif // !_COMPRESSED_INPUT_H_
@@ -0,0 +1,474 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+
+#include "DeterminantServer.h"
+#include "MatrixUtils.h"
+#include "MatrixSerialization.h"
+#include "MultithreadedMatrixGem.h"
+#include "FixedSizeDeterminant.h"
+
+#define SERVER_RECEIVE_CHUNK_SIZE 65536
+#define SERVER_LINE_DELIMITER '/'
+
+server_connection::server_connection(CSocket&& socket) : socket(std::move(socket))
+{
+}
+
+void server_connection::write(const std::vector<char>& data)
+{
+	std::lock_guard<std::mutex> lock(write_guard);
+	socket.send_all(data.data(), data.size());
+}
+
+static matrix_member get_determinant(CMatrix&& matrix)
+{
+	CMatrix gemed_matrix = singlethread_gem_matrix(std::move(matrix));
+	return multiply_matrix_diagonal(gemed_matrix) * gemed_matrix.get_swap_coefficient();
+}
+
+static CMatrix read_binary_matrix(const char* data, size_t size)
+{
+	CBinaryReader reader(data, size);
+	const matrix_size row_count = reader.read_value<matrix_size>();
+	std::vector<std::vector<matrix_member>> rows;
+	matrix_size column_count = 0;
+
+	// every row starts with its column count and first column, the counts come from the client so they are checked before allocating
+	if (row_count > reader.get_remaining_size() / (2 * sizeof(matrix_size)))
+		throw matrix_exception("truncated binary data");
+
+	for (matrix_size row = 0; row < row_count; row++)
+	{
+		// rows longer than the row count can't make up a square matrix
+		rows.push_back(reader.read_row(row_count));
+		column_count = std::max(column_count, (matrix_size)rows.back().size());
+	}
+
+	CMatrix matrix(row_count, column_count);
+
+	for (matrix_size row = 0; row < row_count; row++)
+		for (matrix_size column = 0; column < rows[row].size(); column++)
+			matrix.set_value(row, column, rows[row][column]);
+
+	return matrix;
+}
+
+CDeterminantServer::CDeterminantServer(const std::string& address)
+	:
+	address(address),
+	worker_count(std::max(std::thread::hardware_concurrency(), 1u)),
+	large_matrix_threads(0),
+	small_matrix_size(SERVER_DEFAULT_SMALL_MATRIX_SIZE),
+	batch_size(SERVER_DEFAULT_BATCH_SIZE),
+	result_cache(nullptr),
+	small_requests(SERVER_QUEUE_CAPACITY),
+	large_requests(SERVER_QUEUE_CAPACITY),
+	latency_position(0),
+	processed_count(0),
+	batch_count(0)
+{
+}
+
+void CDeterminantServer::set_worker_count(unsigned int worker_count)
+{
+	if (worker_count > 0)
+		this->worker_count = worker_count;
+}
+
+void CDeterminantServer::set_large_matrix_threads(unsigned int threads)
+{
+	this->large_matrix_threads = threads;
+}
+
+void CDeterminantServer::set_small_matrix_size(matrix_size size)
+{
+	this->small_matrix_size = size;
+}
+
+void CDeterminantServer::set_result_cache(CResultCache* result_cache)
+{
+	this->result_cache = result_cache;
+}
+
+void CDeterminantServer::set_batch_size(size_t batch_size)
+{
+	if (batch_size > 0)
+		this->batch_size = batch_size;
+}
+
+std::string CDeterminantServer::get_statistics() const
+{
+	const size_t small_queue_depth = small_requests.size();
+	const size_t large_queue_depth = large_requests.size();
+
+	std::vector<microsecond_time_difference> sorted_latencies;
+	unsigned long long processed, batches;
+	{
+		std::lock_guard<std::mutex> lock(statistics_guard);
+		sorted_latencies = latencies;
+		processed = processed_count;
+		batches = batch_count;
+	}
+
+	std::sort(sorted_latencies.begin(), sorted_latencies.end());
+
+	auto percentile = [&sorted_latencies](double fraction)
+	{
+		if (sorted_latencies.empty())
+			return 0.0;
+
+		const size_t index = std::min((size_t)(fraction * sorted_latencies.size()), sorted_latencies.size() - 1);
+		return sorted_latencies[index] / 1000.0;
+	};
+
+	std::stringstream statistics;
+	statistics << std::fixed << std::setprecision(3)
+		<< "queue_depth=" << small_queue_depth + large_queue_depth
+		<< " small_queue_depth=" << small_queue_depth
+		<< " large_queue_depth=" << large_queue_depth
+		<< " processed=" << processed
+		<< " small_batches=" << batches
+		<< " p50_ms=" << percentile(0.5)
+		<< " p90_ms=" << percentile(0.9)
+		<< " p99_ms=" << percentile(0.99);
+
+	if (result_cache)
+		statistics << " cache_hits=" << result_cache->get_hit_count() << " cache_misses=" << result_cache->get_miss_count();
+
+	return statistics.str();
+}
+
+void CDeterminantServer::respond(const server_request& request, bool success, const matrix_member& determinant, const std::string& error)
+{
+	const microsecond_time_difference latency = time_diff_us(get_current_time(), request.received_time);
+	{
+		std::lock_guard<std::mutex> lock(statistics_guard);
+
+		if (latencies.size() < SERVER_LATENCY_WINDOW)
+			latencies.push_back(latency);
+		else
+			latencies[latency_position] = latency;
+
+		latency_position = (latency_position + 1) % SERVER_LATENCY_WINDOW;
+		processed_count++;
+	}
+
+	std::vector<char> response;
+
+	if (request.binary)
+	{
+		std::vector<char> payload;
+		CBinaryWriter writer(payload);
+		writer.write_value<uint64_t>(request.id);
+		writer.write_value<bool>(success);
+
+		if (success)
+			writer.write_member(determinant);
+		else
+		{
+			writer.write_value<uint32_t>((uint32_t)error.size());
+			payload.insert(payload.end(), error.begin(), error.end());
+		}
+
+		CBinaryWriter frame_writer(response);
+		frame_writer.write_value<char>(SERVER_BINARY_FRAME_MARKER);
+		frame_writer.write_value<uint64_t>(payload.size());
+		response.insert(response.end(), payload.begin(), payload.end());
+	}
+	else
+	{
+		std::stringstream line;
+		line << request.id << " ";
+
+		if (success)
+			line << std::setprecision(5) << determinant;
+		else
+			line << "error: " << error;
+
+		line << "\n";
+
+		const std::string text = line.str();
+		response.assign(text.begin(), text.end());
+	}
+
+	try
+	{
+		request.connection->write(response);
+	}
+	catch (socket_exception&)
+	{
+		// client went away, nobody to report to
+	}
+}
+
+matrix_member CDeterminantServer::get_cached_determinant(CMatrix&& matrix, const std::function<matrix_member(CMatrix&&)>& compute)
+{
+	if (!result_cache)
+		return compute(std::move(matrix));
+
+	const matrix_hash key = hash_matrix(matrix);
+	matrix_member determinant;
+
+	if (result_cache->find(key, determinant))
+		return determinant;
+
+	determinant = compute(std::move(matrix));
+
+	// failing to cache is not a reason to fail the request
+	try
+	{
+		result_cache->store(key, determinant);
+	}
+	catch (std::runtime_error& e)
+	{
+		std::cerr << "Cache error: " << e.what() << std::endl;
+	}
+
+	return determinant;
+}
+
+void CDeterminantServer::enqueue_request(server_request&& request)
+{
+	if (!is_matrix_square(*request.matrix))
+	{
+		respond(request, false, 0, "matrix is not square (" + std::to_string(request.matrix->get_column_count()) + " columns and " + std::to_string(request.matrix->get_row_count()) + " rows)");
+		return;
+	}
+
+	if (request.matrix->get_row_count() <= small_matrix_size)
+		small_requests.push(std::move(request));
+	else
+		large_requests.push(std::move(request));
+}
+
+void CDeterminantServer::handle_connection(std::shared_ptr<server_connection> connection)
+{
+	std::vector<char> buffer;
+	size_t position = 0; // start of the first unprocessed request in buffer
+	unsigned long long next_id = 0;
+	std::vector<char> chunk(SERVER_RECEIVE_CHUNK_SIZE);
+
+	try
+	{
+		while (true)
+		{
+			const size_t received = connection->socket.receive_some(chunk.data(), chunk.size());
+
+			if (received == 0)
+				break;
+
+			// drop already processed data before appending
+			buffer.erase(buffer.begin(), buffer.begin() + position);
+			position = 0;
+			buffer.insert(buffer.end(), chunk.begin(), chunk.begin() + received);
+
+			while (position < buffer.size())
+			{
+				server_request request;
+				request.connection = connection;
+				request.received_time = get_current_time();
+
+				if (buffer[position] == SERVER_BINARY_FRAME_MARKER)
+				{
+					uint64_t payload_size;
+
+					if (buffer.size() - position < 1 + sizeof(payload_size))
+						break;
+
+					std::memcpy(&payload_size, buffer.data() + position + 1, sizeof(payload_size));
+					const size_t header_size = 1 + sizeof(payload_size);
+
+					if (payload_size > SERVER_MAX_REQUEST_SIZE)
+						throw matrix_exception("binary request exceeds " + std::to_string(SERVER_MAX_REQUEST_SIZE) + " bytes");
+
+					if (buffer.size() - position - header_size < payload_size)
+						break;
+
+					request.binary = true;
+					request.id = next_id++;
+
+					try
+					{
+						request.matrix.reset(new CMatrix(read_binary_matrix(buffer.data() + position + header_size, (size_t)payload_size)));
+						position += header_size + (size_t)payload_size;
+					}
+					catch (std::exception& e)
+					{
+						position += header_size + (size_t)payload_size;
+						respond(request, false, 0, e.what());
+						continue;
+					}
+				}
+				else
+				{
+					const auto line_end = std::find(buffer.begin() + position, buffer.end(), '\n');
+
+					if (line_end == buffer.end())
+					{
+						if (buffer.size() - position > SERVER_MAX_REQUEST_SIZE)
+							throw matrix_exception("request line exceeds " + std::to_string(SERVER_MAX_REQUEST_SIZE) + " bytes");
+
+						break;
+					}
+
+					std::string line(buffer.begin() + position, line_end);
+					position = (size_t)(line_end - buffer.begin()) + 1;
+
+					if (!line.empty() && line.back() == '\r')
+						line.pop_back();
+
+					if (line.find_first_not_of(" \t") == std::string::npos)
+						continue;
+
+					if (line == "stats")
+					{
+						const std::string statistics = get_statistics() + "\n";
+						connection->write(std::vector<char>(statistics.begin(), statistics.end()));
+						continue;
+					}
+
+					request.binary = false;
+					request.id = next_id++;
+
+					try
+					{
+						std::stringstream stream(line);
+						request.matrix.reset(new CMatrix(parse_matrix(stream, SERVER_LINE_DELIMITER)));
+					}
+					catch (std::exception& e)
+					{
+						respond(request, false, 0, e.what());
+						continue;
+					}
+				}
+
+				enqueue_request(std::move(request));
+			}
+		}
+	}
+	catch (std::exception& e)
+	{
+		// only this connection is closed, the server keeps running
+		std::cerr << "Connection error: " << e.what() << std::endl;
+	}
+}
+
+void CDeterminantServer::process_small_requests()
+{
+	std::vector<server_request> batch;
+
+	while (small_requests.pop_batch(batch, batch_size))
+	{
+		{
+			std::lock_guard<std::mutex> lock(statistics_guard);
+			batch_count++;
+		}
+
+		// same-size fixed-size matrices are computed together by the batched kernel
+		std::vector<bool> done(batch.size(), false);
+
+		for (size_t first = 0; first < batch.size(); first++)
+		{
+			if (done[first] || !is_fixed_size_matrix(*batch[first].matrix))
+				continue;
+
+			const matrix_size size = batch[first].matrix->get_row_count();
+			std::vector<size_t> group;
+			std::vector<const CMatrix*> matrices;
+
+			for (size_t i = first; i < batch.size(); i++)
+			{
+				if (!done[i] && batch[i].matrix->get_row_count() == size && is_fixed_size_matrix(*batch[i].matrix))
+				{
+					group.push_back(i);
+					matrices.push_back(batch[i].matrix.get());
+					done[i] = true;
+				}
+			}
+
+			const std::vector<matrix_member> determinants = batched_fixed_size_determinants(matrices);
+
+			for (size_t i = 0; i < group.size(); i++)
+				respond(batch[group[i]], true, determinants[i], "");
+		}
+
+		for (size_t i = 0; i < batch.size(); i++)
+		{
+			if (done[i])
+				continue;
+
+			server_request& request = batch[i];
+
+			try
+			{
+				respond(request, true, get_cached_determinant(std::move(*request.matrix), get_determinant), "");
+			}
+			catch (std::exception& e)
+			{
+				respond(request, false, 0, e.what());
+			}
+		}
+
+		batch.clear();
+	}
+}
+
+void CDeterminantServer::process_large_requests()
+{
+	server_request request;
+
+	// one at a time - the multithreaded GEM uses all the cores on its own
+	while (large_requests.pop(request))
+	{
+		try
+		{
+			const matrix_member determinant = get_cached_determinant(std::move(*request.matrix), [this](CMatrix&& matrix)
+			{
+				CMultithreadedMatrixGem solver(std::move(matrix));
+
+				if (large_matrix_threads > 0)
+					solver.set_num_threads(large_matrix_threads);
+
+				const CMatrix& result = solver.get_result();
+				return matrix_member(multiply_matrix_diagonal(result) * result.get_swap_coefficient());
+			});
+
+			respond(request, true, determinant, "");
+		}
+		catch (std::exception& e)
+		{
+			respond(request, false, 0, e.what());
+		}
+
+		request.matrix.reset();
+	}
+}
+
+void CDeterminantServer::run()
+{
+	CListeningSocket listener(address);
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < worker_count; i++)
+		workers.push_back(std::thread(&CDeterminantServer::process_small_requests, this));
+
+	workers.push_back(std::thread(&CDeterminantServer::process_large_requests, this));
+
+	while (true)
+	{
+		try
+		{
+			std::shared_ptr<server_connection> connection = std::make_shared<server_connection>(listener.accept_connection());
+			std::thread(&CDeterminantServer::handle_connection, this, connection).detach();
+		}
+		catch (socket_exception& e)
+		{
+			std::cerr << "Error: " << e.what() << std::endl;
+		}
+	}
+}
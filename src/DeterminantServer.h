@@ -0,0 +1,95 @@
+#ifndef _DETERMINANT_SERVER_H_
+#define _DETERMINANT_SERVER_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+#include "Util.h"
+#include "Matrix.h"
+#include "Socket.h"
+#include "BoundedQueue.h"
+#include "ResultCache.h"
+
+#define SERVER_DEFAULT_SMALL_MATRIX_SIZE 64
+#define SERVER_DEFAULT_BATCH_SIZE 32
+#define SERVER_QUEUE_CAPACITY 1024
+#define SERVER_LATENCY_WINDOW 4096
+#define SERVER_BINARY_FRAME_MARKER '\x01'
+#define SERVER_MAX_REQUEST_SIZE (256ULL * 1024 * 1024) // longer lines and frames close the connection
+
+// client connection, responses are written by worker threads as soon as their requests are done
+struct server_connection
+{
+	CSocket socket;
+	std::mutex write_guard;
+
+	void write(const std::vector<char>& data);
+
+	server_connection(CSocket&& socket);
+};
+
+struct server_request
+{
+	std::shared_ptr<server_connection> connection;
+	unsigned long long id; // sequence number of the request within its connection
+	bool binary;
+	std::unique_ptr<CMatrix> matrix;
+	time_value received_time;
+};
+
+/*
+ * Long-running determinant service.
+ * Every line sent by a client is one matrix in the usual text format (or the "stats" command), binary requests start with
+ * SERVER_BINARY_FRAME_MARKER followed by 64-bit payload size and the matrix written by CBinaryWriter (row count followed by the rows).
+ * Matrices up to small_matrix_size are processed in batches by a shared pool of workers, larger ones are queued for the multithreaded GEM.
+ * Results of matrices not handled by the fixed-size kernels are looked up in the result cache (if set) before being computed.
+ * Responses are streamed back as they are finished, prefixed with the request id because they can be out of order -
+ * text responses as "ID DETERMINANT" or "ID error: MESSAGE" lines, binary responses as frames with id, success flag and determinant or message.
+ */
+class CDeterminantServer
+{
+private:
+	const std::string address;
+	unsigned int worker_count;
+	unsigned int large_matrix_threads;
+	matrix_size small_matrix_size;
+	size_t batch_size;
+	CResultCache* result_cache; // not owned, can be null
+
+	CBoundedQueue<server_request> small_requests;
+	CBoundedQueue<server_request> large_requests;
+
+	mutable std::mutex statistics_guard;
+	std::vector<microsecond_time_difference> latencies; // ring buffer of the last SERVER_LATENCY_WINDOW latencies
+	size_t latency_position;
+	unsigned long long processed_count;
+	unsigned long long batch_count;
+
+	void handle_connection(std::shared_ptr<server_connection> connection);
+	void process_small_requests();
+	void process_large_requests();
+
+	void enqueue_request(server_request&& request);
+	void respond(const server_request& request, bool success, const matrix_member& determinant, const std::string& error);
+	// computes the determinant by compute unless it is in the result cache
+	matrix_member get_cached_determinant(CMatrix&& matrix, const std::function<matrix_member(CMatrix&&)>& compute);
+
+public:
+	// queue depth, processed count and latency percentiles as a single line
+	std::string get_statistics() const;
+
+	void set_worker_count(unsigned int worker_count);
+	void set_large_matrix_threads(unsigned int threads);
+	void set_small_matrix_size(matrix_size size);
+	void set_batch_size(size_t batch_size);
+	void set_result_cache(CResultCache* result_cache);
+
+	// listens on the address and serves clients, returns only when listening fails
+	void run();
+
+	CDeterminantServer(const std::string& address);
+};
+#endif // !_DETERMINANT_SERVER_H_
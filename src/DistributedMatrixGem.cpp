@@ -0,0 +1,534 @@
+#include <iostream>
+#include <algorithm>
+
+#include "DistributedMatrixGem.h"
+#include "MatrixUtils.h"
+#include "MatrixSerialization.h"
+#include "Socket.h"
+#include "Util.h"
+
+#define DISTRIBUTED_ROWS_PER_MESSAGE 64
+#define DISTRIBUTED_CONTROL_MESSAGE_SIZE 64 // limit of messages received before the column count is known
+
+enum distributed_message_type : unsigned char
+{
+	DISTRIBUTED_SETUP,     // coordinator -> worker: column count
+	DISTRIBUTED_ROWS,      // coordinator -> worker: batch of (row index, row) pairs owned by the worker, shorter rows are padded with zeros
+	DISTRIBUTED_COLUMNS,   // coordinator -> worker: column count grew (a longer row was parsed), rows received so far are padded
+	DISTRIBUTED_START,     // coordinator -> worker: all rows were sent, propose pivot for column 0
+	DISTRIBUTED_CANDIDATE, // worker -> coordinator: best local pivot row for a column
+	DISTRIBUTED_PIVOT,     // coordinator -> worker: chosen pivot row for a column
+	DISTRIBUTED_FINISH     // coordinator -> worker: computation is done
+};
+
+struct distributed_row
+{
+	matrix_size index;
+	std::vector<matrix_member> values;
+};
+
+// size of a row of column_count members written by write_row
+static size_t get_serialized_row_size(matrix_size column_count)
+{
+	return 2 * sizeof(matrix_size) + (size_t)column_count * get_serialized_member_size();
+}
+
+static void check_message_type(CBinaryReader& reader, distributed_message_type expected)
+{
+	if (reader.read_value<unsigned char>() != expected)
+		throw matrix_exception("unexpected distributed gem message");
+}
+
+// state of a single worker, lives for one coordinator connection
+class CDistributedGemWorker
+{
+private:
+	CSocket connection;
+	matrix_size column_count;
+	std::vector<distributed_row> rows;
+
+	const distributed_row* find_candidate(matrix_size column) const;
+	void send_candidate(matrix_size column, const distributed_row* candidate);
+	void eliminate(matrix_size column, const std::vector<matrix_member>& pivot_row, matrix_size pivot_index);
+
+public:
+	void run();
+
+	CDistributedGemWorker(CSocket&& connection);
+};
+
+CDistributedGemWorker::CDistributedGemWorker(CSocket&& connection) : connection(std::move(connection)), column_count(0)
+{
+}
+
+const distributed_row* CDistributedGemWorker::find_candidate(matrix_size column) const
+{
+	const distributed_row* candidate = nullptr;
+
+	for (const distributed_row& row : rows)
+		if (row.values[column] != 0 && (!candidate || abs(row.values[column]) > abs(candidate->values[column])))
+			candidate = &row;
+
+	return candidate;
+}
+
+void CDistributedGemWorker::send_candidate(matrix_size column, const distributed_row* candidate)
+{
+	std::vector<char> message;
+	CBinaryWriter writer(message);
+	writer.write_value<unsigned char>(DISTRIBUTED_CANDIDATE);
+	writer.write_value<matrix_size>(column);
+	writer.write_value<bool>(candidate != nullptr);
+
+	if (candidate)
+	{
+		writer.write_value<matrix_size>(candidate->index);
+		writer.write_row(candidate->values, column); // columns before the current one are already eliminated
+	}
+
+	connection.send_message(message);
+}
+
+void CDistributedGemWorker::eliminate(matrix_size column, const std::vector<matrix_member>& pivot_row, matrix_size pivot_index)
+{
+	// pivot row is finished, it doesn't take part in the elimination anymore
+	rows.erase(std::remove_if(rows.begin(), rows.end(), [pivot_index](const distributed_row& row) { return row.index == pivot_index; }), rows.end());
+
+	const matrix_member& div = pivot_row[column];
+	std::vector<matrix_member> coefs(rows.size());
+
+	auto update_row = [&](size_t i, matrix_size first_column)
+	{
+		if (coefs[i] == 0)
+			return;
+
+		std::vector<matrix_member>& values = rows[i].values;
+
+		for (matrix_size current_column = first_column; current_column < column_count; current_column++)
+			values[current_column] -= pivot_row[current_column] * coefs[i];
+	};
+
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		coefs[i] = rows[i].values[column] / div;
+		rows[i].values[column] = 0;
+	}
+
+	if (column + 1 >= column_count)
+		return;
+
+	// look-ahead: update only the next column, finish the best row for it and propose it before doing the rest of the trailing update
+	for (size_t i = 0; i < rows.size(); i++)
+		rows[i].values[column + 1] -= pivot_row[column + 1] * coefs[i];
+
+	const distributed_row* candidate = find_candidate(column + 1);
+	const size_t candidate_position = candidate ? (size_t)(candidate - rows.data()) : rows.size();
+
+	if (candidate)
+		update_row(candidate_position, column + 2);
+
+	send_candidate(column + 1, candidate);
+
+	for (size_t i = 0; i < rows.size(); i++)
+		if (i != candidate_position)
+			update_row(i, column + 2);
+}
+
+void CDistributedGemWorker::run()
+{
+	std::vector<char> message;
+	bool setup_received = false;
+
+	// the largest message is a full batch of rows, nothing longer is accepted from the coordinator
+	auto get_max_message_size = [this, &setup_received]()
+	{
+		if (!setup_received)
+			return (size_t)DISTRIBUTED_CONTROL_MESSAGE_SIZE;
+
+		const size_t rows_message_size = 1 + DISTRIBUTED_ROWS_PER_MESSAGE * (sizeof(matrix_size) + get_serialized_row_size(column_count));
+		return std::max((size_t)DISTRIBUTED_CONTROL_MESSAGE_SIZE, std::min(rows_message_size, (size_t)SOCKET_DEFAULT_MAX_MESSAGE_SIZE));
+	};
+
+	while (connection.receive_message(message, get_max_message_size()))
+	{
+		CBinaryReader reader(message);
+
+		switch (reader.read_value<unsigned char>())
+		{
+		case DISTRIBUTED_SETUP:
+			column_count = reader.read_value<matrix_size>();
+			setup_received = true;
+			rows.clear();
+			break;
+
+		case DISTRIBUTED_COLUMNS:
+		{
+			const matrix_size new_column_count = reader.read_value<matrix_size>();
+
+			if (!setup_received || new_column_count < column_count)
+				throw matrix_exception("unexpected distributed gem message");
+
+			column_count = new_column_count;
+
+			for (distributed_row& row : rows)
+				row.values.resize(column_count, matrix_member(0));
+			break;
+		}
+
+		case DISTRIBUTED_ROWS:
+			if (!setup_received)
+				throw matrix_exception("unexpected distributed gem message");
+
+			while (!reader.is_at_end())
+			{
+				distributed_row row;
+				row.index = reader.read_value<matrix_size>();
+				row.values = reader.read_row(column_count);
+				row.values.resize(column_count, matrix_member(0));
+				rows.push_back(std::move(row));
+			}
+			break;
+
+		case DISTRIBUTED_START:
+			if (column_count > 0)
+				send_candidate(0, find_candidate(0));
+			break;
+
+		case DISTRIBUTED_PIVOT:
+		{
+			const matrix_size column = reader.read_value<matrix_size>();
+			const matrix_size pivot_index = reader.read_value<matrix_size>();
+			const std::vector<matrix_member> pivot_row = reader.read_row(column_count);
+
+			if (pivot_row.size() != column_count || column >= column_count)
+				throw matrix_exception("distributed pivot row has unexpected size");
+
+			eliminate(column, pivot_row, pivot_index);
+			break;
+		}
+
+		case DISTRIBUTED_FINISH:
+			return;
+
+		default:
+			throw matrix_exception("unexpected distributed gem message");
+		}
+	}
+}
+
+void serve_distributed_gem_worker(const std::string& address)
+{
+	CListeningSocket listener(address);
+
+	while (true)
+	{
+		try
+		{
+			CDistributedGemWorker worker(listener.accept_connection());
+			worker.run();
+		}
+		catch (std::exception& e)
+		{
+			// a broken coordinator must not take the worker down
+			std::cerr << "Worker error: " << e.what() << std::endl;
+		}
+	}
+}
+
+CDistributedMatrixGem::CDistributedMatrixGem(CMatrix&& source_matrix, const std::vector<std::string>& worker_addresses)
+	:
+	result_computed(false),
+	block_size(DISTRIBUTED_DEFAULT_BLOCK_SIZE),
+	worker_addresses(worker_addresses),
+	communication_wait_time(0),
+	bytes_sent(0),
+	bytes_received(0),
+	matrix(std::move(source_matrix)),
+	input(nullptr),
+	line_delimiter(0)
+{
+	if (worker_addresses.empty())
+		throw matrix_exception("distributed gem requires at least one worker");
+}
+
+CDistributedMatrixGem::CDistributedMatrixGem(const CMatrix& source_matrix, const std::vector<std::string>& worker_addresses) : CDistributedMatrixGem(CMatrix(source_matrix), worker_addresses)
+{
+}
+
+CDistributedMatrixGem::CDistributedMatrixGem(std::istream& input, const char line_delimiter, const std::vector<std::string>& worker_addresses)
+	:
+	result_computed(false),
+	block_size(DISTRIBUTED_DEFAULT_BLOCK_SIZE),
+	worker_addresses(worker_addresses),
+	communication_wait_time(0),
+	bytes_sent(0),
+	bytes_received(0),
+	matrix(0, 0),
+	input(&input),
+	line_delimiter(line_delimiter)
+{
+	if (worker_addresses.empty())
+		throw matrix_exception("distributed gem requires at least one worker");
+}
+
+void CDistributedMatrixGem::read_rows(const std::function<void(std::vector<matrix_member>&&)>& row_handler)
+{
+	if (input)
+	{
+		parse_matrix_rows(*input, line_delimiter, row_handler);
+		return;
+	}
+
+	for (matrix_size row = 0; row < matrix.get_row_count(); row++)
+	{
+		const CMatrixRow* matrix_row = matrix.get_row(row);
+		std::vector<matrix_member> values(matrix_row->get_column_count());
+
+		for (matrix_size column = 0; column < values.size(); column++)
+			values[column] = matrix_row->get_column(column);
+
+		matrix.set_row(row, new CMatrixRow(0)); // the row lives on its worker now, release the local copy
+		row_handler(std::move(values));
+	}
+}
+
+unsigned int CDistributedMatrixGem::get_worker_count() const
+{
+	return (unsigned int)worker_addresses.size();
+}
+
+matrix_size CDistributedMatrixGem::get_block_size() const
+{
+	return block_size;
+}
+
+millisecond_time_difference CDistributedMatrixGem::get_setup_time() const
+{
+	return setup_time;
+}
+
+millisecond_time_difference CDistributedMatrixGem::get_computation_time() const
+{
+	return computation_time;
+}
+
+millisecond_time_difference CDistributedMatrixGem::get_cleanup_time() const
+{
+	return cleanup_time;
+}
+
+millisecond_time_difference CDistributedMatrixGem::get_communication_wait_time() const
+{
+	return communication_wait_time;
+}
+
+unsigned long long CDistributedMatrixGem::get_bytes_sent() const
+{
+	return bytes_sent;
+}
+
+unsigned long long CDistributedMatrixGem::get_bytes_received() const
+{
+	return bytes_received;
+}
+
+void CDistributedMatrixGem::set_block_size(matrix_size block_size)
+{
+	if (!this->result_computed && block_size > 0)
+		this->block_size = block_size;
+}
+
+const matrix_member& CDistributedMatrixGem::get_result()
+{
+	if (!result_computed)
+		compute_result();
+
+	return determinant;
+}
+
+void CDistributedMatrixGem::compute_result()
+{
+	if (result_computed)
+		return;
+
+	time_value setup_start = get_current_time();
+
+	const unsigned int worker_count = get_worker_count();
+
+	std::vector<CSocket> workers;
+	for (const std::string& address : worker_addresses)
+		workers.push_back(CSocket::connect_to(address, DISTRIBUTED_CONNECT_TIMEOUT_MS));
+
+	auto send = [this](CSocket& worker, const std::vector<char>& message)
+	{
+		worker.send_message(message);
+		bytes_sent += message.size();
+	};
+
+	auto broadcast = [&send, &workers](const std::vector<char>& message)
+	{
+		for (CSocket& worker : workers)
+			send(worker, message);
+	};
+
+	std::vector<char> message;
+	CBinaryWriter writer(message);
+
+	// deal rows block-cyclically as they come, the column count is announced with the first row and again whenever a longer row shows up
+	std::vector<std::vector<char>> row_messages(worker_count);
+	std::vector<matrix_size> row_message_counts(worker_count, 0);
+	matrix_size size = 0;
+	matrix_size column_count = 0;
+	bool setup_sent = false;
+
+	auto flush_rows = [&](unsigned int owner)
+	{
+		if (row_message_counts[owner] == 0)
+			return;
+
+		send(workers[owner], row_messages[owner]);
+		row_messages[owner].clear();
+		row_message_counts[owner] = 0;
+	};
+
+	auto announce_column_count = [&](distributed_message_type type)
+	{
+		message.clear();
+		writer.write_value<unsigned char>(type);
+		writer.write_value<matrix_size>(column_count);
+		broadcast(message);
+	};
+
+	read_rows([&](std::vector<matrix_member>&& values)
+	{
+		if (!setup_sent || values.size() > column_count)
+		{
+			column_count = std::max(column_count, (matrix_size)values.size());
+			announce_column_count(setup_sent ? DISTRIBUTED_COLUMNS : DISTRIBUTED_SETUP);
+			setup_sent = true;
+		}
+
+		const matrix_size row = size++;
+		const unsigned int owner = (unsigned int)((row / block_size) % worker_count);
+
+		// workers don't accept messages longer than SOCKET_DEFAULT_MAX_MESSAGE_SIZE
+		if (row_messages[owner].size() + sizeof(matrix_size) + get_serialized_row_size((matrix_size)values.size()) > SOCKET_DEFAULT_MAX_MESSAGE_SIZE)
+			flush_rows(owner);
+
+		CBinaryWriter row_writer(row_messages[owner]);
+
+		if (row_message_counts[owner] == 0)
+			row_writer.write_value<unsigned char>(DISTRIBUTED_ROWS);
+
+		row_writer.write_value<matrix_size>(row);
+		row_writer.write_row(values);
+
+		if (++row_message_counts[owner] == DISTRIBUTED_ROWS_PER_MESSAGE)
+			flush_rows(owner);
+	});
+
+	if (!setup_sent)
+		announce_column_count(DISTRIBUTED_SETUP);
+
+	for (unsigned int worker = 0; worker < worker_count; worker++)
+		flush_rows(worker);
+
+	if (size != column_count)
+	{
+		message.clear();
+		writer.write_value<unsigned char>(DISTRIBUTED_FINISH);
+		broadcast(message);
+
+		throw non_square_matrix_exception(size, column_count);
+	}
+
+	// candidate is the column, its flag, the row index and the row itself
+	const size_t max_candidate_size = 1 + 2 * sizeof(matrix_size) + sizeof(bool) + get_serialized_row_size(size);
+
+	time_value computation_start = get_current_time();
+
+	message.clear();
+	writer.write_value<unsigned char>(DISTRIBUTED_START);
+	broadcast(message);
+
+	std::vector<matrix_size> permutation;
+	determinant = size == 0 ? 0 : 1;
+
+	for (matrix_size column = 0; column < size; column++)
+	{
+		bool found_pivot = false;
+		matrix_size pivot_index = 0;
+		std::vector<matrix_member> pivot_row;
+
+		time_value wait_start = get_current_time();
+
+		for (CSocket& worker : workers)
+		{
+			if (!worker.receive_message(message, max_candidate_size))
+				throw matrix_exception("distributed worker disconnected");
+
+			bytes_received += message.size();
+
+			CBinaryReader reader(message);
+			check_message_type(reader, DISTRIBUTED_CANDIDATE);
+
+			if (reader.read_value<matrix_size>() != column)
+				throw matrix_exception("distributed worker is out of sync");
+
+			if (!reader.read_value<bool>())
+				continue;
+
+			const matrix_size candidate_index = reader.read_value<matrix_size>();
+			std::vector<matrix_member> candidate_row = reader.read_row(size);
+
+			if (candidate_row.size() != size)
+				throw matrix_exception("distributed candidate row has unexpected size");
+
+			if (!found_pivot || abs(candidate_row[column]) > abs(pivot_row[column]))
+			{
+				found_pivot = true;
+				pivot_index = candidate_index;
+				pivot_row = std::move(candidate_row);
+			}
+		}
+
+		communication_wait_time += time_diff(get_current_time(), wait_start);
+
+		// whole remaining column is zero
+		if (!found_pivot)
+		{
+			determinant = 0;
+			break;
+		}
+
+		determinant *= pivot_row[column];
+		permutation.push_back(pivot_index);
+
+		if (column + 1 < size)
+		{
+			message.clear();
+			writer.write_value<unsigned char>(DISTRIBUTED_PIVOT);
+			writer.write_value<matrix_size>(column);
+			writer.write_value<matrix_size>(pivot_index);
+			writer.write_row(pivot_row, column);
+			broadcast(message);
+		}
+	}
+
+	if (determinant != 0)
+		determinant *= get_permutation_sign(permutation);
+
+	time_value cleanup_start = get_current_time();
+
+	message.clear();
+	writer.write_value<unsigned char>(DISTRIBUTED_FINISH);
+	broadcast(message);
+	workers.clear();
+
+	result_computed = true;
+	time_value cleanup_finished_time = get_current_time();
+
+	setup_time = time_diff(computation_start, setup_start);
+	computation_time = time_diff(cleanup_start, computation_start);
+	cleanup_time = time_diff(cleanup_finished_time, cleanup_start);
+}
@@ -0,0 +1,71 @@
+#ifndef _DISTRIBUTED_MATRIX_GEM_H_
+#define _DISTRIBUTED_MATRIX_GEM_H_
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <functional>
+
+#include "Util.h"
+#include "Matrix.h"
+
+#define DISTRIBUTED_DEFAULT_BLOCK_SIZE 16
+#define DISTRIBUTED_CONNECT_TIMEOUT_MS 5000
+
+/*
+ * Coordinator of the distributed gauss elimination.
+ * Matrix rows are dealt to the workers in a block-cyclic way (block of block_size rows goes to worker (row / block_size) % worker_count),
+ * the coordinator then only picks pivots - each worker proposes its best pivot row for the current column, the coordinator
+ * broadcasts the chosen one and workers eliminate their rows with it. Workers update the next column first and send the next
+ * proposal before finishing the rest of the trailing update, so choosing and broadcasting the next pivot overlaps with the computation.
+ * Pivot rows are never moved, the determinant is the product of pivots multiplied by the sign of the resulting row permutation.
+ * Given an input stream, rows are dealt to their workers as soon as they are parsed, so the coordinator never holds the whole matrix.
+ */
+class CDistributedMatrixGem
+{
+private:
+	bool result_computed;
+	matrix_size block_size;
+	std::vector<std::string> worker_addresses;
+
+	millisecond_time_difference setup_time;
+	millisecond_time_difference computation_time;
+	millisecond_time_difference cleanup_time;
+	millisecond_time_difference communication_wait_time;
+	unsigned long long bytes_sent;
+	unsigned long long bytes_received;
+
+	CMatrix matrix;
+	std::istream* input; // rows are parsed from input if set, taken from matrix otherwise
+	const char line_delimiter;
+	matrix_member determinant;
+
+	// calls row_handler for every row of the matrix (parsed or taken from matrix, which gets emptied)
+	void read_rows(const std::function<void(std::vector<matrix_member>&&)>& row_handler);
+
+public:
+	unsigned int get_worker_count() const;
+	matrix_size get_block_size() const;
+
+	millisecond_time_difference get_setup_time() const;
+	millisecond_time_difference get_computation_time() const;
+	millisecond_time_difference get_cleanup_time() const;
+	millisecond_time_difference get_communication_wait_time() const;
+	unsigned long long get_bytes_sent() const;
+	unsigned long long get_bytes_received() const;
+
+	void set_block_size(matrix_size block_size);
+
+	const matrix_member& get_result();
+	// throws non_square_matrix_exception if the dealt matrix turns out not to be square
+	void compute_result();
+
+	CDistributedMatrixGem(CMatrix&& source_matrix, const std::vector<std::string>& worker_addresses);
+	CDistributedMatrixGem(const CMatrix& source_matrix, const std::vector<std::string>& worker_addresses);
+	CDistributedMatrixGem(std::istream& input, const char line_delimiter, const std::vector<std::string>& worker_addresses);
+};
+
+// listens on address and serves coordinators one at a time, never returns unless listening fails
+void serve_distributed_gem_worker(const std::string& address);
+
+#endif // !_DISTRIBUTED_MATRIX_GEM_H_
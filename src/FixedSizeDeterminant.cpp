@@ -0,0 +1,120 @@
+#include "FixedSizeDeterminant.h"
+#include "MatrixUtils.h"
+
+template <matrix_size N>
+static matrix_member compute_fixed_determinant(const CMatrix& matrix)
+{
+	fixed_matrix<N, matrix_member> values;
+
+	for (matrix_size row = 0; row < N; row++)
+	{
+		const CMatrixRow* matrix_row = matrix.get_row(row);
+
+		for (matrix_size column = 0; column < N; column++)
+			values[row * N + column] = matrix_row->get_column(column);
+	}
+
+	return fixed_determinant<N, matrix_member>(values);
+}
+
+template <matrix_size N, size_t Lanes>
+static void compute_batch(const std::vector<const CMatrix*>& matrices, size_t first, std::vector<matrix_member>& determinants)
+{
+	fixed_matrix_batch<N, Lanes, matrix_member> batch;
+	std::array<matrix_member, Lanes> batch_determinants;
+
+	for (size_t lane = 0; lane < Lanes; lane++)
+	{
+		const CMatrix* matrix = first + lane < matrices.size() ? matrices[first + lane] : nullptr;
+
+		for (matrix_size row = 0; row < N; row++)
+			for (matrix_size column = 0; column < N; column++)
+			{
+				// unused lanes get identity, so they never need the scalar fallback
+				batch[(row * N + column) * Lanes + lane] = matrix ? matrix->get_value(row, column) : matrix_member(row == column ? 1 : 0);
+			}
+	}
+
+	batched_fixed_determinant<N, Lanes, matrix_member>(batch, batch_determinants);
+
+	for (size_t lane = 0; lane < Lanes && first + lane < matrices.size(); lane++)
+		determinants.push_back(batch_determinants[lane]);
+}
+
+template <matrix_size N>
+static void compute_batched_determinants(const std::vector<const CMatrix*>& matrices, std::vector<matrix_member>& determinants)
+{
+	// widest batches while there are enough matrices, the rest in narrower ones so only a few lanes are padding
+	for (size_t first = 0; first < matrices.size(); )
+	{
+		const size_t remaining = matrices.size() - first;
+
+		if (remaining >= FIXED_SIZE_BATCH_MAX_LANES)
+		{
+			compute_batch<N, FIXED_SIZE_BATCH_MAX_LANES>(matrices, first, determinants);
+			first += FIXED_SIZE_BATCH_MAX_LANES;
+		}
+		else if (remaining >= FIXED_SIZE_BATCH_MAX_LANES / 2)
+		{
+			compute_batch<N, FIXED_SIZE_BATCH_MAX_LANES / 2>(matrices, first, determinants);
+			first += FIXED_SIZE_BATCH_MAX_LANES / 2;
+		}
+		else
+		{
+			compute_batch<N, FIXED_SIZE_BATCH_MIN_LANES>(matrices, first, determinants);
+			first += FIXED_SIZE_BATCH_MIN_LANES;
+		}
+	}
+}
+
+matrix_member fixed_size_determinant(const CMatrix& matrix)
+{
+	if (!is_fixed_size_matrix(matrix))
+		throw matrix_exception("matrix is not a square matrix of size 1 to " + std::to_string(FIXED_SIZE_MAX));
+
+	switch (matrix.get_row_count())
+	{
+	case 1: return compute_fixed_determinant<1>(matrix);
+	case 2: return compute_fixed_determinant<2>(matrix);
+	case 3: return compute_fixed_determinant<3>(matrix);
+	case 4: return compute_fixed_determinant<4>(matrix);
+	case 5: return compute_fixed_determinant<5>(matrix);
+	case 6: return compute_fixed_determinant<6>(matrix);
+	case 7: return compute_fixed_determinant<7>(matrix);
+	default: return compute_fixed_determinant<8>(matrix);
+	}
+}
+
+std::vector<matrix_member> batched_fixed_size_determinants(const std::vector<const CMatrix*>& matrices)
+{
+	std::vector<matrix_member> determinants;
+
+	if (matrices.empty())
+		return determinants;
+
+	const matrix_size size = matrices[0]->get_row_count();
+
+	for (const CMatrix* matrix : matrices)
+		if (!is_fixed_size_matrix(*matrix) || matrix->get_row_count() != size)
+			throw matrix_exception("batched matrices have to be square matrices of the same size 1 to " + std::to_string(FIXED_SIZE_MAX));
+
+	determinants.reserve(matrices.size());
+
+	switch (size)
+	{
+	case 1:
+		for (const CMatrix* matrix : matrices)
+			determinants.push_back(matrix->get_value(0, 0));
+		break;
+
+	case 2: compute_batched_determinants<2>(matrices, determinants); break;
+	case 3: compute_batched_determinants<3>(matrices, determinants); break;
+	case 4: compute_batched_determinants<4>(matrices, determinants); break;
+	case 5: compute_batched_determinants<5>(matrices, determinants); break;
+	case 6: compute_batched_determinants<6>(matrices, determinants); break;
+	case 7: compute_batched_determinants<7>(matrices, determinants); break;
+	default: compute_batched_determinants<8>(matrices, determinants); break;
+	}
+
+	return determinants;
+}
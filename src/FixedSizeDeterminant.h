@@ -0,0 +1,190 @@
+#ifndef _FIXED_SIZE_DETERMINANT_H_
+#define _FIXED_SIZE_DETERMINANT_H_
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <utility>
+
+#include "Matrix.h"
+
+#define FIXED_SIZE_MAX 8
+#define FIXED_SIZE_BATCH_MIN_LANES 4 // batches are 16, 8 or 4 matrices wide
+#define FIXED_SIZE_BATCH_MAX_LANES 16
+
+/*
+ * Determinant kernels for matrices with size known at compile time. Values live in a std::array (no heap rows),
+ * sizes up to 3 use closed forms and larger ones use gauss elimination with partial pivoting whose loops have
+ * compile-time bounds, so the compiler can unroll them completely.
+ */
+
+template <matrix_size N, class T>
+using fixed_matrix = std::array<T, N * N>;
+
+// elimination step K, recursion ends with the last column
+template <matrix_size N, matrix_size K, class T>
+struct fixed_elimination_step
+{
+	static void apply(fixed_matrix<N, T>& m, T& determinant)
+	{
+		using std::abs; // multiprecision types provide their own abs
+
+		matrix_size pivot = K;
+
+		for (matrix_size row = K + 1; row < N; row++)
+			if (abs(m[row * N + K]) > abs(m[pivot * N + K]))
+				pivot = row;
+
+		if (m[pivot * N + K] == 0)
+		{
+			determinant = 0;
+			return;
+		}
+
+		if (pivot != K)
+		{
+			for (matrix_size column = K; column < N; column++)
+				std::swap(m[K * N + column], m[pivot * N + column]);
+
+			determinant = -determinant;
+		}
+
+		const T div = m[K * N + K];
+		determinant *= div;
+
+		for (matrix_size row = K + 1; row < N; row++)
+		{
+			const T coef = m[row * N + K] / div;
+
+			for (matrix_size column = K + 1; column < N; column++)
+				m[row * N + column] -= m[K * N + column] * coef;
+		}
+
+		fixed_elimination_step<N, K + 1, T>::apply(m, determinant);
+	}
+};
+
+template <matrix_size N, class T>
+struct fixed_elimination_step<N, N, T>
+{
+	static void apply(fixed_matrix<N, T>&, T&)
+	{
+	}
+};
+
+template <matrix_size N, class T>
+struct fixed_determinant_kernel
+{
+	static T compute(fixed_matrix<N, T> m)
+	{
+		T determinant = 1;
+		fixed_elimination_step<N, 0, T>::apply(m, determinant);
+		return determinant;
+	}
+};
+
+template <class T>
+struct fixed_determinant_kernel<1, T>
+{
+	static T compute(const fixed_matrix<1, T>& m)
+	{
+		return m[0];
+	}
+};
+
+template <class T>
+struct fixed_determinant_kernel<2, T>
+{
+	static T compute(const fixed_matrix<2, T>& m)
+	{
+		return m[0] * m[3] - m[1] * m[2];
+	}
+};
+
+template <class T>
+struct fixed_determinant_kernel<3, T>
+{
+	static T compute(const fixed_matrix<3, T>& m)
+	{
+		return m[0] * (m[4] * m[8] - m[5] * m[7])
+			- m[1] * (m[3] * m[8] - m[5] * m[6])
+			+ m[2] * (m[3] * m[7] - m[4] * m[6]);
+	}
+};
+
+template <matrix_size N, class T>
+inline T fixed_determinant(const fixed_matrix<N, T>& m)
+{
+	return fixed_determinant_kernel<N, T>::compute(m);
+}
+
+/*
+ * Structure-of-arrays batch - element (row, column) of all Lanes matrices is stored next to each other,
+ * so every step of the elimination is a loop over lanes that maps to SIMD lanes for primitive value types.
+ * Pivot rows are chosen per lane (largest element as in the scalar kernel), only the row swaps are done lane by lane.
+ */
+template <matrix_size N, size_t Lanes, class T>
+using fixed_matrix_batch = std::array<T, N * N * Lanes>;
+
+template <matrix_size N, size_t Lanes, class T>
+inline void batched_fixed_determinant(fixed_matrix_batch<N, Lanes, T> batch, std::array<T, Lanes>& determinants)
+{
+	using std::abs; // multiprecision types provide their own abs
+
+	std::array<matrix_size, Lanes> pivots;
+	std::array<T, Lanes> coefs;
+
+	for (size_t lane = 0; lane < Lanes; lane++)
+		determinants[lane] = 1;
+
+	for (matrix_size k = 0; k < N; k++)
+	{
+		for (size_t lane = 0; lane < Lanes; lane++)
+			pivots[lane] = k;
+
+		for (matrix_size row = k + 1; row < N; row++)
+			for (size_t lane = 0; lane < Lanes; lane++)
+				if (abs(batch[(row * N + k) * Lanes + lane]) > abs(batch[(pivots[lane] * N + k) * Lanes + lane]))
+					pivots[lane] = row;
+
+		for (size_t lane = 0; lane < Lanes; lane++)
+		{
+			if (pivots[lane] == k)
+				continue;
+
+			for (matrix_size column = k; column < N; column++)
+				std::swap(batch[(k * N + column) * Lanes + lane], batch[(pivots[lane] * N + column) * Lanes + lane]);
+
+			determinants[lane] = -determinants[lane];
+		}
+
+		const T* pivot_row = batch.data() + (k * N) * Lanes;
+
+		// lanes with zero pivot end up with zero determinant and skip the elimination through zero coefs
+		for (size_t lane = 0; lane < Lanes; lane++)
+			determinants[lane] *= pivot_row[k * Lanes + lane];
+
+		for (matrix_size row = k + 1; row < N; row++)
+		{
+			T* current_row = batch.data() + (row * N) * Lanes;
+
+			for (size_t lane = 0; lane < Lanes; lane++)
+				coefs[lane] = pivot_row[k * Lanes + lane] == 0 ? T(0) : current_row[k * Lanes + lane] / pivot_row[k * Lanes + lane];
+
+			for (matrix_size column = k + 1; column < N; column++)
+				for (size_t lane = 0; lane < Lanes; lane++)
+					current_row[column * Lanes + lane] -= pivot_row[column * Lanes + lane] * coefs[lane];
+		}
+	}
+}
+
+// dispatches square matrix of size 1..FIXED_SIZE_MAX to the matching fixed-size kernel
+matrix_member fixed_size_determinant(const CMatrix& matrix);
+// computes determinants of same-size square matrices (size 1..FIXED_SIZE_MAX) in batches of 16, 8 or 4 depending on how many are left
+std::vector<matrix_member> batched_fixed_size_determinants(const std::vector<const CMatrix*>& matrices);
+
+inline bool is_fixed_size_matrix(const CMatrix& matrix)
+{
+	return matrix.get_row_count() > 0 && matrix.get_row_count() <= FIXED_SIZE_MAX && matrix.get_row_count() == matrix.get_column_count();
+}
+#endif // !_FIXED_SIZE_DETERMINANT_H_
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstdint>
+
+#include "GemCheckpoint.h"
+#include "MatrixUtils.h"
+#include "MatrixSerialization.h"
+
+gem_checkpoint::gem_checkpoint(CMatrix&& matrix, matrix_size next_row) : matrix(std::move(matrix)), next_row(next_row)
+{
+}
+
+gem_checkpoint load_gem_checkpoint(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+		throw std::runtime_error("cannot open checkpoint \"" + path + "\"");
+
+	const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	CBinaryReader reader(data);
+
+	if (reader.read_value<uint32_t>() != GEM_CHECKPOINT_MAGIC || reader.read_value<uint32_t>() != GEM_CHECKPOINT_VERSION)
+		throw matrix_exception("\"" + path + "\" is not a checkpoint file");
+
+	const matrix_size row_count = reader.read_value<matrix_size>();
+	const matrix_size column_count = reader.read_value<matrix_size>();
+	const matrix_size next_row = reader.read_value<matrix_size>();
+	const int swap_coefficient = reader.read_value<int>();
+
+	// the header is checked before allocating, a damaged one would make the elimination skip rows or allocate anything
+	// every row starts with its column count and first column
+	if (row_count != column_count || next_row > row_count || (swap_coefficient != 1 && swap_coefficient != -1) || row_count > reader.get_remaining_size() / (2 * sizeof(matrix_size)))
+		throw matrix_exception("corrupted checkpoint \"" + path + "\"");
+
+	CMatrix matrix(row_count, column_count);
+	matrix.set_swap_coefficient(swap_coefficient);
+
+	for (matrix_size row = 0; row < row_count; row++)
+	{
+		const std::vector<matrix_member> values = reader.read_row(column_count);
+
+		if (values.size() != column_count)
+			throw matrix_exception("corrupted checkpoint \"" + path + "\"");
+
+		for (matrix_size column = 0; column < column_count; column++)
+			matrix.set_value(row, column, values[column]);
+	}
+
+	return gem_checkpoint(std::move(matrix), next_row);
+}
+
+void save_gem_checkpoint(const std::string& path, const CMatrix& matrix, matrix_size next_row)
+{
+	std::vector<char> data;
+	CBinaryWriter writer(data);
+
+	writer.write_value<uint32_t>(GEM_CHECKPOINT_MAGIC);
+	writer.write_value<uint32_t>(GEM_CHECKPOINT_VERSION);
+	writer.write_value<matrix_size>(matrix.get_row_count());
+	writer.write_value<matrix_size>(matrix.get_column_count());
+	writer.write_value<matrix_size>(next_row);
+	writer.write_value<int>(matrix.get_swap_coefficient());
+
+	for (matrix_size row = 0; row < matrix.get_row_count(); row++)
+		writer.write_row(*matrix.get_row(row));
+
+	const std::string temporary_path = path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), (std::streamsize)data.size());
+
+		if (!file)
+			throw std::runtime_error("cannot write checkpoint \"" + temporary_path + "\"");
+	}
+
+	if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+		throw std::runtime_error("cannot replace checkpoint \"" + path + "\"");
+}
+
+CGemCheckpointWriter::CGemCheckpointWriter(const std::string& path) : path(path), written_count(0), run(true), writer_thread(std::thread(&CGemCheckpointWriter::work, this))
+{
+}
+
+CGemCheckpointWriter::~CGemCheckpointWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		run = false;
+		work_sync.notify_all();
+	}
+
+	// checkpoint that is still waiting gets written before the thread finishes
+	if (writer_thread.joinable())
+		writer_thread.join();
+}
+
+unsigned long long CGemCheckpointWriter::get_written_count()
+{
+	std::lock_guard<std::mutex> lock(guard);
+	return written_count;
+}
+
+void CGemCheckpointWriter::submit(const CMatrix& matrix, matrix_size next_row)
+{
+	// copying is the only part done on the caller's thread
+	std::unique_ptr<gem_checkpoint> snapshot(new gem_checkpoint(CMatrix(matrix), next_row));
+
+	std::lock_guard<std::mutex> lock(guard);
+	waiting = std::move(snapshot);
+	work_sync.notify_all();
+}
+
+void CGemCheckpointWriter::flush()
+{
+	std::unique_lock<std::mutex> lock(guard);
+	work_sync.wait(lock, [this] { return !waiting && !writing; });
+}
+
+void CGemCheckpointWriter::work()
+{
+	std::unique_lock<std::mutex> lock(guard);
+
+	while (true)
+	{
+		work_sync.wait(lock, [this] { return !run || waiting; });
+
+		if (!waiting)
+			return;
+
+		writing = std::move(waiting);
+		lock.unlock();
+
+		try
+		{
+			save_gem_checkpoint(path, writing->matrix, writing->next_row);
+		}
+		catch (std::runtime_error& e)
+		{
+			// the computation goes on, it just can't be resumed from this point
+			std::cerr << "Checkpoint error: " << e.what() << std::endl;
+		}
+
+		lock.lock();
+		writing.reset();
+		written_count++;
+		work_sync.notify_all();
+	}
+}
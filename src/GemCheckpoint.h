@@ -0,0 +1,59 @@
+#ifndef _GEM_CHECKPOINT_H_
+#define _GEM_CHECKPOINT_H_
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Matrix.h"
+
+#define GEM_CHECKPOINT_MAGIC 0x4b43444dU // "MDCK"
+#define GEM_CHECKPOINT_VERSION 1U
+
+// partially eliminated matrix (including its swap coefficient) and the first row that is not eliminated yet
+struct gem_checkpoint
+{
+	CMatrix matrix;
+	matrix_size next_row;
+
+	gem_checkpoint(CMatrix&& matrix, matrix_size next_row);
+};
+
+gem_checkpoint load_gem_checkpoint(const std::string& path);
+// writes to a temporary file first and then renames it, so the previous checkpoint survives a crash in the middle of writing
+void save_gem_checkpoint(const std::string& path, const CMatrix& matrix, matrix_size next_row);
+
+/*
+ * Writes checkpoints on its own thread. The computation only copies the matrix into a free buffer,
+ * serialization and disk writes happen off the hot path. There are two buffers - one being written and one waiting,
+ * a newer snapshot replaces the waiting one if the writer doesn't keep up.
+ */
+class CGemCheckpointWriter
+{
+private:
+	const std::string path;
+
+	std::unique_ptr<gem_checkpoint> writing;
+	std::unique_ptr<gem_checkpoint> waiting;
+	unsigned long long written_count;
+
+	bool run;
+	std::mutex guard;
+	std::condition_variable work_sync;
+	std::thread writer_thread;
+
+	void work();
+
+public:
+	unsigned long long get_written_count();
+
+	void submit(const CMatrix& matrix, matrix_size next_row);
+	// waits until all submitted checkpoints are written
+	void flush();
+
+	CGemCheckpointWriter(const std::string& path);
+	~CGemCheckpointWriter();
+};
+#endif // !_GEM_CHECKPOINT_H_
@@ -126,6 +126,14 @@ int CMatrix::get_swap_coefficient() const
 	return swap_coefficient;
 }
 
+void CMatrix::set_swap_coefficient(int swap_coefficient)
+{
+	if (swap_coefficient != 1 && swap_coefficient != -1)
+		throw matrix_exception("swap coefficient has to be 1 or -1");
+
+	this->swap_coefficient = swap_coefficient;
+}
+
 CMatrixRow* CMatrix::get_row(matrix_size row) const
 {
 	if (row >= row_count)
@@ -39,6 +39,7 @@ private:
 
 public:
 	int get_swap_coefficient() const;
+	void set_swap_coefficient(int swap_coefficient);
 	void set_value(matrix_size row, matrix_size column, const matrix_member& value);
 	void set_row(matrix_size row_index, CMatrixRow* row);
 
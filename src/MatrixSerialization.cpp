@@ -0,0 +1,87 @@
+#include "MatrixSerialization.h"
+
+size_t get_serialized_member_size()
+{
+	static const size_t member_size = []()
+	{
+		std::vector<char> buffer;
+		CBinaryWriter(buffer).write_member(0);
+		return buffer.size();
+	}();
+
+	return member_size;
+}
+
+CBinaryWriter::CBinaryWriter(std::vector<char>& buffer) : buffer(buffer)
+{
+}
+
+void CBinaryWriter::write_member(const matrix_member& value)
+{
+	// serialize() is not const even though saving does not modify the value
+	const_cast<matrix_member&>(value).backend().serialize(*this, 0);
+}
+
+void CBinaryWriter::write_row(const CMatrixRow& row, matrix_size first_column)
+{
+	const matrix_size column_count = row.get_column_count();
+	write_value<matrix_size>(column_count);
+	write_value<matrix_size>(first_column);
+
+	for (matrix_size column = first_column; column < column_count; column++)
+		write_member(row.get_column(column));
+}
+
+void CBinaryWriter::write_row(const std::vector<matrix_member>& row, matrix_size first_column)
+{
+	const matrix_size column_count = (matrix_size)row.size();
+	write_value<matrix_size>(column_count);
+	write_value<matrix_size>(first_column);
+
+	for (matrix_size column = first_column; column < column_count; column++)
+		write_member(row[column]);
+}
+
+CBinaryReader::CBinaryReader(const char* data, size_t size) : data(data), size(size), position(0)
+{
+}
+
+CBinaryReader::CBinaryReader(const std::vector<char>& buffer) : CBinaryReader(buffer.data(), buffer.size())
+{
+}
+
+matrix_member CBinaryReader::read_member()
+{
+	matrix_member value;
+	value.backend().serialize(*this, 0);
+	return value;
+}
+
+std::vector<matrix_member> CBinaryReader::read_row(matrix_size max_column_count)
+{
+	const matrix_size column_count = read_value<matrix_size>();
+	const matrix_size first_column = read_value<matrix_size>();
+
+	if (first_column > column_count || column_count > max_column_count)
+		throw matrix_exception("malformed binary row");
+
+	if (column_count - first_column > get_remaining_size() / get_serialized_member_size())
+		throw matrix_exception("truncated binary data");
+
+	std::vector<matrix_member> row(column_count, matrix_member(0));
+
+	for (matrix_size column = first_column; column < column_count; column++)
+		row[column] = read_member();
+
+	return row;
+}
+
+bool CBinaryReader::is_at_end() const
+{
+	return position >= size;
+}
+
+size_t CBinaryReader::get_remaining_size() const
+{
+	return size - position;
+}
@@ -0,0 +1,90 @@
+#ifndef _MATRIX_SERIALIZATION_H_
+#define _MATRIX_SERIALIZATION_H_
+
+#include <vector>
+#include <cstring>
+#include <type_traits>
+#include <limits>
+
+#include <boost/serialization/nvp.hpp>
+
+#include "Matrix.h"
+#include "MatrixUtils.h"
+
+// size of a member written by CBinaryWriter, all members take the same space
+size_t get_serialized_member_size();
+
+// appends compact binary representation of values to a byte buffer, the format is only meant to be read by the same build
+class CBinaryWriter
+{
+private:
+	std::vector<char>& buffer;
+
+public:
+	template <class T>
+	void write_value(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be written directly");
+
+		const char* bytes = reinterpret_cast<const char*>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	// used by matrix_member backend serialize()
+	template <class T>
+	CBinaryWriter& operator&(const boost::serialization::nvp<T>& value)
+	{
+		write_value(value.value());
+		return (*this);
+	}
+
+	void write_member(const matrix_member& value);
+	void write_row(const CMatrixRow& row, matrix_size first_column = 0);
+	void write_row(const std::vector<matrix_member>& row, matrix_size first_column = 0);
+
+	CBinaryWriter(std::vector<char>& buffer);
+};
+
+// reads values written by CBinaryWriter, throws matrix_exception when the buffer is too short
+class CBinaryReader
+{
+private:
+	const char* data;
+	size_t size;
+	size_t position;
+
+public:
+	template <class T>
+	T read_value()
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be read directly");
+
+		if (size - position < sizeof(T))
+			throw matrix_exception("truncated binary data");
+
+		T value;
+		std::memcpy(&value, data + position, sizeof(T));
+		position += sizeof(T);
+		return value;
+	}
+
+	// used by matrix_member backend serialize()
+	template <class T>
+	CBinaryReader& operator&(const boost::serialization::nvp<T>& value)
+	{
+		value.value() = read_value<T>();
+		return (*this);
+	}
+
+	matrix_member read_member();
+	// reads row written by write_row, columns skipped by the writer are set to 0
+	// rows longer than max_column_count and rows whose members can't fit into the rest of the data are rejected before allocating
+	std::vector<matrix_member> read_row(matrix_size max_column_count = std::numeric_limits<matrix_size>::max());
+
+	bool is_at_end() const;
+	size_t get_remaining_size() const;
+
+	CBinaryReader(const std::vector<char>& buffer);
+	CBinaryReader(const char* data, size_t size);
+};
+#endif // !_MATRIX_SERIALIZATION_H_
@@ -1,9 +1,52 @@
+#include <utility>
+#include <limits>
+#include <algorithm>
+
 #include "MatrixUtils.h"
 
 matrix_exception::matrix_exception(const std::string& message) : std::runtime_error(message)
 {
 }
 
+non_square_matrix_exception::non_square_matrix_exception(matrix_size row_count, matrix_size column_count)
+	:
+	matrix_exception("cannot compute determinant of a matrix that is not square (input matrix has " + std::to_string(column_count) + " columns and " + std::to_string(row_count) + " rows)"),
+	row_count(row_count),
+	column_count(column_count)
+{
+}
+
+matrix_size non_square_matrix_exception::get_row_count() const
+{
+	return row_count;
+}
+
+matrix_size non_square_matrix_exception::get_column_count() const
+{
+	return column_count;
+}
+
+// unit roundoff of the arithmetic actually used - cpp_dec_float computes with more digits than its numeric_limits promise,
+// so it's measured on a few operations with all digits used against a much wider type
+matrix_member get_arithmetic_epsilon()
+{
+	typedef boost::multiprecision::number<boost::multiprecision::cpp_dec_float<100>> reference_member;
+	reference_member epsilon = 0;
+
+	for (int i = 3; i < 40; i += 2)
+	{
+		const matrix_member a = matrix_member(1) / i;
+		const matrix_member b = matrix_member(2) / (i + 4);
+		const reference_member reference_a(a), reference_b(b);
+
+		epsilon = std::max(epsilon, reference_member(abs((reference_member(a * b) - reference_a * reference_b) / (reference_a * reference_b))));
+		epsilon = std::max(epsilon, reference_member(abs((reference_member(a / b) - reference_a / reference_b) / (reference_a / reference_b))));
+		epsilon = std::max(epsilon, reference_member(abs((reference_member(a + b) - (reference_a + reference_b)) / (reference_a + reference_b))));
+	}
+
+	return std::max(matrix_member(epsilon), matrix_member(std::numeric_limits<matrix_member>::min()));
+}
+
 matrix_member multiply_matrix_diagonal(const CMatrix& matrix)
 {
 	if (matrix.get_row_count() == 0) // empty matrix
@@ -23,11 +66,9 @@ matrix_member multiply_matrix_diagonal(const CMatrix& matrix)
 	return rtn;
 }
 
-CMatrix parse_matrix(std::istream& stream, const char line_delimiter)
+void parse_matrix_rows(std::istream& stream, const char line_delimiter, const std::function<void(std::vector<matrix_member>&&)>& row_handler)
 {
-	matrix_size row_count = 0, column_count = 0, max_columns = 0;
 	std::vector<matrix_member> row_values;
-	std::vector<std::vector<matrix_member>> parsed_values;
 
 	while (!stream.eof())
 	{
@@ -36,13 +77,8 @@ CMatrix parse_matrix(std::istream& stream, const char line_delimiter)
 		if (next_char == line_delimiter) // new row
 		{
 			stream.ignore();
-			row_count++;
-
-			if (column_count > max_columns)
-				max_columns = column_count;
-
-			column_count = 0;
-			parsed_values.push_back(std::move(row_values));
+			row_handler(std::move(row_values));
+			row_values.clear();
 			continue;
 		}
 
@@ -54,16 +90,32 @@ CMatrix parse_matrix(std::istream& stream, const char line_delimiter)
 
 		matrix_member value;
 		stream >> value;
+
+		// a lone '-' would otherwise leave the stream failed and never at eof
+		if (stream.fail())
+			throw matrix_exception("invalid value in matrix");
+
 		row_values.push_back(value);
-		column_count++;
 	}
 
 	// there's no line_delimiter after last row
-	row_count++; 
-	parsed_values.push_back(row_values);
-	if (column_count > max_columns)
-		max_columns = column_count;
+	row_handler(std::move(row_values));
+}
+
+CMatrix parse_matrix(std::istream& stream, const char line_delimiter)
+{
+	matrix_size max_columns = 0;
+	std::vector<std::vector<matrix_member>> parsed_values;
+
+	parse_matrix_rows(stream, line_delimiter, [&](std::vector<matrix_member>&& row_values)
+	{
+		if (row_values.size() > max_columns)
+			max_columns = (matrix_size)row_values.size();
 
+		parsed_values.push_back(std::move(row_values));
+	});
+
+	const matrix_size row_count = (matrix_size)parsed_values.size();
 	CMatrix parsed_matrix(row_count, max_columns); // all values are initially 0
 
 	// create CMatrix from parsed values
@@ -78,7 +130,105 @@ CMatrix parse_matrix(std::istream& stream, const char line_delimiter)
 	return parsed_matrix;
 }
 
-CMatrix singlethread_gem_matrix(CMatrix&& matrix)
+void reduce_row_by_pivot(std::vector<matrix_member>& row, const std::vector<matrix_member>& pivot_row, matrix_size pivot_column)
+{
+	if (pivot_column >= row.size() || row[pivot_column] == 0)
+		return;
+
+	const matrix_member coef = row[pivot_column] / pivot_row[pivot_column];
+	const matrix_size column_count = (matrix_size)pivot_row.size();
+
+	if (row.size() < column_count)
+		row.resize(column_count, matrix_member(0));
+
+	for (matrix_size column = 0; column < column_count; column++)
+		row[column] -= pivot_row[column] * coef;
+
+	row[pivot_column] = 0;
+}
+
+int get_permutation_sign(const std::vector<matrix_size>& permutation)
+{
+	std::vector<bool> visited(permutation.size(), false);
+	int sign = 1;
+
+	// every cycle of length L is composed of L-1 transpositions
+	for (matrix_size start = 0; start < permutation.size(); start++)
+	{
+		if (visited[start])
+			continue;
+
+		matrix_size cycle_length = 0;
+
+		for (matrix_size current = start; !visited[current]; current = permutation[current])
+		{
+			visited[current] = true;
+			cycle_length++;
+		}
+
+		if (cycle_length % 2 == 0)
+			sign = -sign;
+	}
+
+	return sign;
+}
+
+CEliminationLog::CEliminationLog() : swap_count(0)
+{
+}
+
+size_t CEliminationLog::get_operation_count() const
+{
+	return operations.size();
+}
+
+unsigned long long CEliminationLog::get_swap_count() const
+{
+	return swap_count;
+}
+
+void CEliminationLog::record_swap(matrix_size row1, matrix_size row2)
+{
+	operations.push_back({ true, row1, row2, 0 });
+	swap_count++;
+}
+
+void CEliminationLog::record_elimination(matrix_size target_row, matrix_size source_row, const matrix_member& coef)
+{
+	// subtracting zero multiple doesn't change anything
+	if (coef != 0)
+		operations.push_back({ false, target_row, source_row, coef });
+}
+
+void CEliminationLog::clear()
+{
+	operations.clear();
+	swap_count = 0;
+}
+
+void CEliminationLog::undo(std::vector<matrix_member>& vector) const
+{
+	for (auto op = operations.rbegin(); op != operations.rend(); ++op)
+	{
+		if (op->swap)
+			std::swap(vector[op->target], vector[op->source]);
+		else
+			vector[op->target] += op->coef * vector[op->source];
+	}
+}
+
+void CEliminationLog::undo_absolute(std::vector<matrix_member>& vector) const
+{
+	for (auto op = operations.rbegin(); op != operations.rend(); ++op)
+	{
+		if (op->swap)
+			std::swap(vector[op->target], vector[op->source]);
+		else
+			vector[op->target] += abs(op->coef) * vector[op->source];
+	}
+}
+
+CMatrix singlethread_gem_matrix(CMatrix&& matrix, CEliminationLog* log)
 {
 	CMatrix gem_matrix(std::move(matrix));
 	const matrix_size matrix_row_count = gem_matrix.get_row_count();
@@ -88,7 +238,7 @@ CMatrix singlethread_gem_matrix(CMatrix&& matrix)
 	{
 		for (matrix_size j = i + 1; j < matrix_row_count; j++)
 		{
-			eliminate_matrix_row(gem_matrix, i, j);
+			eliminate_matrix_row(gem_matrix, i, j, log);
 		}
 	}
 
@@ -101,7 +251,7 @@ CMatrix singlethread_gem_matrix(const CMatrix& original_matrix)
 	return singlethread_gem_matrix(std::move(gem_matrix));
 }
 
-void eliminate_matrix_row(CMatrix& matrix, matrix_size& previous_row_index, matrix_size& current_row_index)
+void eliminate_matrix_row(CMatrix& matrix, matrix_size& previous_row_index, matrix_size& current_row_index, CEliminationLog* log)
 {
 	CMatrixRow* previous_row = matrix.get_row(previous_row_index);
 
@@ -109,9 +259,15 @@ void eliminate_matrix_row(CMatrix& matrix, matrix_size& previous_row_index, matr
 	{
 		matrix.swap_rows(previous_row_index, current_row_index);
 		previous_row = matrix.get_row(previous_row_index);
+
+		if (log)
+			log->record_swap(previous_row_index, current_row_index);
 	}
 	CMatrixRow* current_row = matrix.get_row(current_row_index);
 
 	matrix_member coef = previous_row_index >= previous_row->get_column_count() || previous_row->get_column(previous_row_index) == 0 ? matrix_member(1) : current_row->get_column(previous_row_index) / previous_row->get_column(previous_row_index);
 	*current_row -= *previous_row * coef;
+
+	if (log)
+		log->record_elimination(current_row_index, previous_row_index, coef);
 }
\ No newline at end of file
@@ -3,7 +3,10 @@
 
 #include <exception>
 #include <stdexcept>
+#include <string>
 #include <ios>
+#include <vector>
+#include <functional>
 
 #include "Matrix.h"
 
@@ -13,16 +16,74 @@ public:
 	matrix_exception(const std::string& message);
 };
 
+// thrown by the implementations which find out the dimensions only while parsing the matrix
+class non_square_matrix_exception : public matrix_exception
+{
+private:
+	matrix_size row_count;
+	matrix_size column_count;
+
+public:
+	matrix_size get_row_count() const;
+	matrix_size get_column_count() const;
+
+	non_square_matrix_exception(matrix_size row_count, matrix_size column_count);
+};
+
 inline bool is_matrix_square(const CMatrix& matrix)
 {
 	return matrix.get_row_count() == matrix.get_column_count();
 }
 
+// unit roundoff of matrix_member arithmetic, measured - numeric_limits understates the digits actually used
+matrix_member get_arithmetic_epsilon();
 matrix_member multiply_matrix_diagonal(const CMatrix& matrix);
 CMatrix parse_matrix(std::istream& stream, const char line_delimiter);
+// parses the same format as parse_matrix but hands every row over as soon as it is read, rows are not padded with zeros
+void parse_matrix_rows(std::istream& stream, const char line_delimiter, const std::function<void(std::vector<matrix_member>&&)>& row_handler);
+
+// subtracts multiple of the finished pivot_row from row so that row has 0 in pivot_column, row is extended with zeros if pivot_row is longer
+void reduce_row_by_pivot(std::vector<matrix_member>& row, const std::vector<matrix_member>& pivot_row, matrix_size pivot_column);
+// sign of the permutation given as a sequence of distinct indices 0..n-1
+int get_permutation_sign(const std::vector<matrix_size>& permutation);
+
+/*
+ * Row operations done by gauss elimination, in order. Undoing them (in reverse order) on U * v gives L * U * v,
+ * which has to match A * v - this is what result verification relies on.
+ */
+class CEliminationLog
+{
+private:
+	struct operation
+	{
+		bool swap;
+		matrix_size target;
+		matrix_size source;
+		matrix_member coef; // target row -= coef * source row
+	};
+
+	std::vector<operation> operations;
+	unsigned long long swap_count;
+
+public:
+	size_t get_operation_count() const;
+	unsigned long long get_swap_count() const;
+
+	void record_swap(matrix_size row1, matrix_size row2);
+	void record_elimination(matrix_size target_row, matrix_size source_row, const matrix_member& coef);
+	void clear();
+
+	// applies inverse operations in reverse order
+	void undo(std::vector<matrix_member>& vector) const;
+	// undoes with absolute values of coefs, on |U| * |v| gives |L| * |U| * |v| which rounding errors are relative to
+	void undo_absolute(std::vector<matrix_member>& vector) const;
+
+	CEliminationLog();
+};
 
-CMatrix singlethread_gem_matrix(CMatrix&& matrix);
+// log (if not null) records all row operations
+CMatrix singlethread_gem_matrix(CMatrix&& matrix, CEliminationLog* log = nullptr);
 CMatrix singlethread_gem_matrix(const CMatrix& original_matrix);
-void eliminate_matrix_row(CMatrix& matrix, matrix_size& previous_row_index, matrix_size& current_row_index);
+void eliminate_matrix_row(CMatrix& matrix, matrix_size& previous_row_index, matrix_size& current_row_index, CEliminationLog* log = nullptr);
 
 #endif // !_MATRIX_UTILS_H_
@@ -86,7 +86,25 @@ void CSolver::work()
 	}
 }
 
-CMultithreadedMatrixGem::CMultithreadedMatrixGem(CMatrix&& source_matrix) : result_computed(false), sync_wait_time(0), matrix(std::move(source_matrix))
+cancellation_exception::cancellation_exception() : matrix_exception("computation was cancelled")
+{
+}
+
+CCancellationToken::CCancellationToken() : cancelled(false)
+{
+}
+
+void CCancellationToken::cancel()
+{
+	cancelled = true;
+}
+
+bool CCancellationToken::is_cancelled() const
+{
+	return cancelled;
+}
+
+CMultithreadedMatrixGem::CMultithreadedMatrixGem(CMatrix&& source_matrix) : result_computed(false), first_row(1), checkpoint_interval(0), checkpoint_count(0), elimination_log(nullptr), sync_wait_time(0), matrix(std::move(source_matrix))
 {
 	// don't make more threads than there is matrix columns
 	num_threads = (unsigned int)std::min(std::max((int)std::thread::hardware_concurrency(), 1), (int)matrix.get_column_count());
@@ -96,6 +114,31 @@ CMultithreadedMatrixGem::CMultithreadedMatrixGem(const CMatrix& source_matrix) :
 {
 }
 
+CMultithreadedMatrixGem::CMultithreadedMatrixGem(gem_checkpoint&& checkpoint) : CMultithreadedMatrixGem(std::move(checkpoint.matrix))
+{
+	first_row = std::max(checkpoint.next_row, (matrix_size)1);
+}
+
+void CMultithreadedMatrixGem::set_checkpoint(const std::string& path, millisecond_time_difference interval)
+{
+	if (!this->result_computed)
+	{
+		this->checkpoint_path = path;
+		this->checkpoint_interval = interval;
+	}
+}
+
+void CMultithreadedMatrixGem::set_elimination_log(CEliminationLog* log)
+{
+	if (!this->result_computed)
+		this->elimination_log = log;
+}
+
+unsigned long long CMultithreadedMatrixGem::get_checkpoint_count() const
+{
+	return checkpoint_count;
+}
+
 void CMultithreadedMatrixGem::set_num_threads(unsigned int num_threads)
 {
 	// no point in updating num_threads if the result is already computed
@@ -137,6 +180,17 @@ const CMatrix& CMultithreadedMatrixGem::get_result()
 }
 
 void CMultithreadedMatrixGem::compute_result()
+{
+	compute_result(nullptr, nullptr);
+}
+
+std::future<void> CMultithreadedMatrixGem::compute_result_async(std::shared_ptr<CCancellationToken> token, gem_progress_callback progress)
+{
+	// the token is captured by value so it stays alive as long as the computation needs it
+	return std::async(std::launch::async, [this, token, progress]() { compute_result(token.get(), progress); });
+}
+
+void CMultithreadedMatrixGem::compute_result(const CCancellationToken* token, const gem_progress_callback& progress)
 {
 	if (result_computed)
 		return;
@@ -151,11 +205,28 @@ void CMultithreadedMatrixGem::compute_result()
 	const matrix_size matrix_row_count = matrix.get_row_count();
 	const matrix_size matrix_column_count = matrix.get_column_count();
 
+	std::unique_ptr<CGemCheckpointWriter> checkpoint_writer;
+	if (!checkpoint_path.empty())
+		checkpoint_writer.reset(new CGemCheckpointWriter(checkpoint_path));
+
 	time_value computation_start = get_current_time();
+	time_value last_checkpoint_time = computation_start;
+
+	// total work is sum of eliminations done for every row, row k is eliminated against k previous rows
+	const double total_work = (double)matrix_row_count * (matrix_row_count - 1) / 2;
+	// work finished before this run (by the run which took the checkpoint), elapsed time only covers the rest
+	const double previous_work = (double)first_row * (first_row - 1) / 2;
 
-	// start at second matrix row
-	for (matrix_size current_row = 1; current_row < matrix_row_count; current_row++)
+	// start at second matrix row (unless resuming from a checkpoint)
+	for (matrix_size current_row = first_row; current_row < matrix_row_count; current_row++)
 	{
+		// check between pivot steps, workers are idle at this point - destroying solvers during unwinding stops them
+		if (token && token->is_cancelled())
+		{
+			first_row = current_row; // a new run doesn't need to redo the finished rows
+			throw cancellation_exception();
+		}
+
 		CMatrixRow* current_row_ptr = matrix.get_row(current_row); 
 
 		// for all preceding rows
@@ -177,9 +248,15 @@ void CMultithreadedMatrixGem::compute_result()
 
 				if (previous_row < matrix_column_count)
 					div = previous_row_ptr->get_column(previous_row);
+
+				if (elimination_log)
+					elimination_log->record_swap(previous_row, current_row);
 			}
 
 			matrix_member coef = previous_row >= matrix_column_count || div == 0 ? matrix_member(1) : (current_row_ptr->get_column(previous_row) / div);
+
+			if (elimination_log)
+				elimination_log->record_elimination(current_row, previous_row, coef);
 			
 			// assign work to workers
 			for (auto& solver : solvers)
@@ -201,11 +278,31 @@ void CMultithreadedMatrixGem::compute_result()
 			time_value sync_wait_end = get_current_time();
 			sync_wait_time += time_diff(sync_wait_end, sync_wait_start);
 		}
+
+		if (checkpoint_writer && time_diff(get_current_time(), last_checkpoint_time) >= checkpoint_interval)
+		{
+			checkpoint_writer->submit(matrix, current_row + 1);
+			checkpoint_count++;
+			last_checkpoint_time = get_current_time();
+		}
+
+		if (progress)
+		{
+			const double done_work = (double)current_row * (current_row + 1) / 2;
+
+			gem_progress current_progress;
+			current_progress.current_step = current_row;
+			current_progress.total_steps = matrix_row_count - 1;
+			current_progress.elapsed_time = time_diff(get_current_time(), computation_start);
+			current_progress.estimated_remaining_time = (millisecond_time_difference)(current_progress.elapsed_time * (total_work - done_work) / (done_work - previous_work));
+			progress(current_progress);
+		}
 	}
 
 	time_value cleanup_start = get_current_time();
 	
 	// stop all workers
+	checkpoint_writer.reset(); // waits for the last checkpoint to be written
 	solvers.clear(); // this will clear the std::vector of workers, which will result in unique ptrs being destroyed, which will result in CSolver destructor call, which does the actual thread stopping and cleanup
 
 	result_computed = true;
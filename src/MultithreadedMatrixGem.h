@@ -5,9 +5,43 @@
 #include <thread>
 #include <condition_variable>
 #include <mutex>
+#include <future>
+#include <memory>
+#include <functional>
 
 #include "Util.h"
 #include "Matrix.h"
+#include "MatrixUtils.h"
+#include "GemCheckpoint.h"
+
+class cancellation_exception : public matrix_exception
+{
+public:
+	cancellation_exception();
+};
+
+// shared between the caller and the computation, checked by the computation between pivot steps
+class CCancellationToken
+{
+private:
+	std::atomic_bool cancelled;
+
+public:
+	void cancel();
+	bool is_cancelled() const;
+
+	CCancellationToken();
+};
+
+struct gem_progress
+{
+	matrix_size current_step; // number of finished pivot steps
+	matrix_size total_steps;
+	millisecond_time_difference elapsed_time; // since the start of this run, not of the computation resumed from a checkpoint
+	millisecond_time_difference estimated_remaining_time; // based on the work done so far in this run, step k costs k row eliminations
+};
+
+typedef std::function<void(const gem_progress&)> gem_progress_callback;
 
 class CSolver
 {
@@ -43,6 +77,13 @@ class CMultithreadedMatrixGem
 private:
 	bool result_computed;
 	unsigned int num_threads;
+	matrix_size first_row; // rows before this one are already eliminated
+
+	std::string checkpoint_path;
+	millisecond_time_difference checkpoint_interval;
+	unsigned long long checkpoint_count;
+
+	CEliminationLog* elimination_log;
 
 	millisecond_time_difference setup_time;
 	millisecond_time_difference computation_time;
@@ -59,12 +100,24 @@ public:
 	millisecond_time_difference get_cleanup_time() const;
 	millisecond_time_difference get_sync_wait_time() const;
 
+	unsigned long long get_checkpoint_count() const;
+
 	void set_num_threads(unsigned int num_threads);
+	// after every pivot step that ends at least interval ms after the previous checkpoint, the state is saved to path on a background thread
+	void set_checkpoint(const std::string& path, millisecond_time_difference interval);
+	// log (if not null) records all row operations, it has to outlive the computation
+	void set_elimination_log(CEliminationLog* log);
 
 	const CMatrix& get_result();
 	void compute_result();
+	// throws cancellation_exception when token gets cancelled, the matrix is left partially eliminated (which doesn't change its determinant) and the computation can be started again
+	void compute_result(const CCancellationToken* token, const gem_progress_callback& progress);
+	// runs compute_result on a new thread, progress is called from that thread and this object has to outlive the returned future
+	std::future<void> compute_result_async(std::shared_ptr<CCancellationToken> token = nullptr, gem_progress_callback progress = nullptr);
 
 	CMultithreadedMatrixGem(CMatrix&& source_matrix);
 	CMultithreadedMatrixGem(const CMatrix& source_matrix);
+	// continues from the first row that wasn't eliminated when the checkpoint was taken
+	CMultithreadedMatrixGem(gem_checkpoint&& checkpoint);
 };
 #endif // !_MULTITHREADED_MATRIX_GEM_H_
@@ -0,0 +1,314 @@
+#include <future>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <stdlib.h>
+
+#include "OutOfCoreMatrixGem.h"
+#include "MatrixUtils.h"
+#include "MatrixSerialization.h"
+#include "Util.h"
+
+typedef std::vector<std::vector<matrix_member>> matrix_panel;
+
+// unnamed temporary file, it is unlinked right after creation so the OS removes it once it's closed
+class CTemporaryFile
+{
+private:
+	int descriptor;
+	unsigned long long file_size;
+
+public:
+	// returns offset at which data was written
+	unsigned long long append(const std::vector<char>& data);
+	void read(unsigned long long offset, size_t size, std::vector<char>& data) const;
+
+	CTemporaryFile(const CTemporaryFile& original) = delete;
+	CTemporaryFile(const std::string& directory);
+	~CTemporaryFile();
+};
+
+CTemporaryFile::CTemporaryFile(const std::string& directory) : file_size(0)
+{
+	std::string path = directory + "/matrix_out_of_core_XXXXXX";
+	descriptor = mkstemp(&path[0]);
+
+	if (descriptor < 0)
+		throw matrix_exception("cannot create temporary file in \"" + directory + "\": " + std::strerror(errno));
+
+	unlink(path.c_str());
+}
+
+CTemporaryFile::~CTemporaryFile()
+{
+	close(descriptor);
+}
+
+unsigned long long CTemporaryFile::append(const std::vector<char>& data)
+{
+	const unsigned long long offset = file_size;
+	size_t written = 0;
+
+	while (written < data.size())
+	{
+		const ssize_t result = pwrite(descriptor, data.data() + written, data.size() - written, (off_t)(offset + written));
+
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			throw matrix_exception(std::string("cannot write temporary file: ") + std::strerror(errno));
+		}
+
+		written += (size_t)result;
+	}
+
+	file_size += data.size();
+	return offset;
+}
+
+void CTemporaryFile::read(unsigned long long offset, size_t size, std::vector<char>& data) const
+{
+	data.resize(size);
+	size_t read_total = 0;
+
+	// pread doesn't move the file offset, so prefetching thread and writing thread don't interfere
+	while (read_total < size)
+	{
+		const ssize_t result = pread(descriptor, data.data() + read_total, size - read_total, (off_t)(offset + read_total));
+
+		if (result < 0 && errno == EINTR)
+			continue;
+
+		if (result <= 0)
+			throw matrix_exception("cannot read temporary file");
+
+		read_total += (size_t)result;
+	}
+}
+
+struct file_extent
+{
+	unsigned long long offset;
+	size_t size;
+};
+
+static matrix_panel read_panel(const CTemporaryFile& file, const file_extent& extent, matrix_size column_count)
+{
+	std::vector<char> buffer;
+	file.read(extent.offset, extent.size, buffer);
+
+	matrix_panel panel;
+	CBinaryReader reader(buffer);
+
+	while (!reader.is_at_end())
+	{
+		panel.push_back(reader.read_row());
+		panel.back().resize(column_count, matrix_member(0)); // spooled rows are not padded
+	}
+
+	return panel;
+}
+
+COutOfCoreMatrixGem::COutOfCoreMatrixGem(std::istream& input, const char line_delimiter, size_t memory_limit, const std::string& temporary_directory)
+	:
+	result_computed(false),
+	memory_limit(memory_limit),
+	temporary_directory(temporary_directory),
+	input(input),
+	line_delimiter(line_delimiter),
+	size(0),
+	panel_row_count(0),
+	panel_count(0),
+	io_wait_time(0),
+	bytes_read(0),
+	bytes_written(0)
+{
+}
+
+matrix_size COutOfCoreMatrixGem::get_size() const
+{
+	return size;
+}
+
+matrix_size COutOfCoreMatrixGem::get_panel_row_count() const
+{
+	return panel_row_count;
+}
+
+matrix_size COutOfCoreMatrixGem::get_panel_count() const
+{
+	return panel_count;
+}
+
+millisecond_time_difference COutOfCoreMatrixGem::get_spooling_time() const
+{
+	return spooling_time;
+}
+
+millisecond_time_difference COutOfCoreMatrixGem::get_computation_time() const
+{
+	return computation_time;
+}
+
+millisecond_time_difference COutOfCoreMatrixGem::get_io_wait_time() const
+{
+	return io_wait_time;
+}
+
+unsigned long long COutOfCoreMatrixGem::get_bytes_read() const
+{
+	return bytes_read;
+}
+
+unsigned long long COutOfCoreMatrixGem::get_bytes_written() const
+{
+	return bytes_written;
+}
+
+const matrix_member& COutOfCoreMatrixGem::get_result()
+{
+	if (!result_computed)
+		compute_result();
+
+	return determinant;
+}
+
+void COutOfCoreMatrixGem::compute_result()
+{
+	if (result_computed)
+		return;
+
+	time_value spooling_start = get_current_time();
+
+	// spool parsed rows, only their positions are kept in memory
+	CTemporaryFile spool_file(temporary_directory);
+	std::vector<file_extent> spooled_rows;
+	matrix_size max_columns = 0;
+	std::vector<char> buffer;
+
+	parse_matrix_rows(input, line_delimiter, [&](std::vector<matrix_member>&& row_values)
+	{
+		if (row_values.size() > max_columns)
+			max_columns = (matrix_size)row_values.size();
+
+		buffer.clear();
+		CBinaryWriter writer(buffer);
+		writer.write_row(row_values);
+
+		file_extent extent;
+		extent.offset = spool_file.append(buffer);
+		extent.size = buffer.size();
+		spooled_rows.push_back(extent);
+		bytes_written += buffer.size();
+	});
+
+	size = (matrix_size)spooled_rows.size();
+
+	if (size != max_columns)
+		throw non_square_matrix_exception(size, max_columns);
+
+	const size_t row_memory = std::max((size_t)size * sizeof(matrix_member), (size_t)1);
+	panel_row_count = (matrix_size)std::min(std::max(memory_limit / (OUT_OF_CORE_PANELS_IN_MEMORY * row_memory), (size_t)1), (size_t)size);
+	panel_count = panel_row_count == 0 ? 0 : (size + panel_row_count - 1) / panel_row_count;
+
+	time_value computation_start = get_current_time();
+	spooling_time = time_diff(computation_start, spooling_start);
+
+	CTemporaryFile finished_file(temporary_directory);
+	std::vector<file_extent> finished_panels;
+	std::vector<matrix_size> pivot_columns;
+
+	auto load_finished_panel = [&](matrix_size panel)
+	{
+		return read_panel(finished_file, finished_panels[panel], size);
+	};
+
+	determinant = size == 0 ? 0 : 1;
+
+	for (matrix_size panel = 0; panel < panel_count && determinant != 0; panel++)
+	{
+		const matrix_size first_row = panel * panel_row_count;
+		const matrix_size last_row = std::min(first_row + panel_row_count, size) - 1;
+
+		file_extent input_extent;
+		input_extent.offset = spooled_rows[first_row].offset;
+		input_extent.size = (size_t)(spooled_rows[last_row].offset + spooled_rows[last_row].size - input_extent.offset);
+		bytes_read += input_extent.size;
+
+		matrix_panel current_panel = read_panel(spool_file, input_extent, size);
+
+		// reduce by all finished panels, the next one is read while the current one is being applied
+		std::future<matrix_panel> prefetch;
+
+		if (panel > 0)
+			prefetch = std::async(std::launch::async, load_finished_panel, 0);
+
+		for (matrix_size finished_panel = 0; finished_panel < panel; finished_panel++)
+		{
+			time_value wait_start = get_current_time();
+			const matrix_panel pivot_rows = prefetch.get();
+			io_wait_time += time_diff(get_current_time(), wait_start);
+			bytes_read += finished_panels[finished_panel].size;
+
+			if (finished_panel + 1 < panel)
+				prefetch = std::async(std::launch::async, load_finished_panel, finished_panel + 1);
+
+			const matrix_size pivot_row_offset = finished_panel * panel_row_count;
+
+			for (std::vector<matrix_member>& row : current_panel)
+				for (matrix_size pivot_row = 0; pivot_row < pivot_rows.size(); pivot_row++)
+					reduce_row_by_pivot(row, pivot_rows[pivot_row], pivot_columns[pivot_row_offset + pivot_row]);
+		}
+
+		// finish rows of the current panel one by one
+		for (matrix_size row = 0; row < current_panel.size(); row++)
+		{
+			std::vector<matrix_member>& values = current_panel[row];
+
+			for (matrix_size pivot_row = 0; pivot_row < row; pivot_row++)
+				reduce_row_by_pivot(values, current_panel[pivot_row], pivot_columns[first_row + pivot_row]);
+
+			matrix_size pivot_column = 0;
+
+			for (matrix_size column = 1; column < size; column++)
+				if (abs(values[column]) > abs(values[pivot_column]))
+					pivot_column = column;
+
+			// row is linearly dependent on the previous ones
+			if (values[pivot_column] == 0)
+			{
+				determinant = 0;
+				break;
+			}
+
+			determinant *= values[pivot_column];
+			pivot_columns.push_back(pivot_column);
+		}
+
+		// last panel is never needed again
+		if (determinant != 0 && panel + 1 < panel_count)
+		{
+			buffer.clear();
+			CBinaryWriter writer(buffer);
+
+			for (const std::vector<matrix_member>& row : current_panel)
+				writer.write_row(row);
+
+			file_extent extent;
+			extent.offset = finished_file.append(buffer);
+			extent.size = buffer.size();
+			finished_panels.push_back(extent);
+			bytes_written += buffer.size();
+		}
+	}
+
+	if (determinant != 0)
+		determinant *= get_permutation_sign(pivot_columns);
+
+	result_computed = true;
+	computation_time = time_diff(get_current_time(), computation_start);
+}
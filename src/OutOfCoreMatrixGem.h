@@ -0,0 +1,58 @@
+#ifndef _OUT_OF_CORE_MATRIX_GEM_H_
+#define _OUT_OF_CORE_MATRIX_GEM_H_
+
+#include <string>
+#include <istream>
+
+#include "Util.h"
+#include "Matrix.h"
+
+#define OUT_OF_CORE_PANELS_IN_MEMORY 4 // panel being reduced, panel being applied, prefetched panel and a serialization buffer
+
+/*
+ * Gauss elimination of a matrix that doesn't need to fit into memory.
+ * Parsed rows are spooled to a temporary file right away, the matrix is then processed in panels of rows sized so that
+ * OUT_OF_CORE_PANELS_IN_MEMORY panels fit into memory_limit. Every panel is reduced by all already finished panels,
+ * which are streamed back from a second temporary file while the next one is being prefetched asynchronously.
+ * Pivots are chosen by columns (largest element of the reduced row), so finished rows never move.
+ */
+class COutOfCoreMatrixGem
+{
+private:
+	bool result_computed;
+	size_t memory_limit;
+	std::string temporary_directory;
+
+	std::istream& input;
+	const char line_delimiter;
+
+	matrix_size size;
+	matrix_size panel_row_count;
+	matrix_size panel_count;
+
+	millisecond_time_difference spooling_time;
+	millisecond_time_difference computation_time;
+	millisecond_time_difference io_wait_time;
+	unsigned long long bytes_read;
+	unsigned long long bytes_written;
+
+	matrix_member determinant;
+
+public:
+	matrix_size get_size() const;
+	matrix_size get_panel_row_count() const;
+	matrix_size get_panel_count() const;
+
+	millisecond_time_difference get_spooling_time() const;
+	millisecond_time_difference get_computation_time() const;
+	millisecond_time_difference get_io_wait_time() const;
+	unsigned long long get_bytes_read() const;
+	unsigned long long get_bytes_written() const;
+
+	const matrix_member& get_result();
+	void compute_result();
+
+	// temporary files are created in temporary_directory and removed right away, so they never outlive the process
+	COutOfCoreMatrixGem(std::istream& input, const char line_delimiter, size_t memory_limit, const std::string& temporary_directory);
+};
+#endif // !_OUT_OF_CORE_MATRIX_GEM_H_
@@ -0,0 +1,443 @@
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <atomic>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#include "ResultCache.h"
+#include "MatrixUtils.h"
+#include "MatrixSerialization.h"
+
+// the keys only need to differ, the hash is not used against adversarial inputs
+#define RESULT_CACHE_KEY_LOW_0 0x0706050403020100ULL
+#define RESULT_CACHE_KEY_LOW_1 0x0f0e0d0c0b0a0908ULL
+#define RESULT_CACHE_KEY_HIGH_0 0x9e3779b97f4a7c15ULL
+#define RESULT_CACHE_KEY_HIGH_1 0xc2b2ae3d27d4eb4fULL
+
+bool matrix_hash::operator==(const matrix_hash& other) const
+{
+	return low == other.low && high == other.high;
+}
+
+std::string matrix_hash::to_string() const
+{
+	std::stringstream stream;
+	stream << std::hex << std::setfill('0') << std::setw(16) << high << std::setw(16) << low;
+	return stream.str();
+}
+
+size_t matrix_hash_hasher::operator()(const matrix_hash& hash) const
+{
+	return (size_t)(hash.low ^ hash.high);
+}
+
+static inline uint64_t rotate_left(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+{
+	v0 += v1; v1 = rotate_left(v1, 13); v1 ^= v0; v0 = rotate_left(v0, 32);
+	v2 += v3; v3 = rotate_left(v3, 16); v3 ^= v2;
+	v0 += v3; v3 = rotate_left(v3, 21); v3 ^= v0;
+	v2 += v1; v1 = rotate_left(v1, 17); v1 ^= v2; v2 = rotate_left(v2, 32);
+}
+
+uint64_t siphash(const char* data, size_t size, uint64_t key0, uint64_t key1)
+{
+	uint64_t v0 = 0x736f6d6570736575ULL ^ key0;
+	uint64_t v1 = 0x646f72616e646f6dULL ^ key1;
+	uint64_t v2 = 0x6c7967656e657261ULL ^ key0;
+	uint64_t v3 = 0x7465646279746573ULL ^ key1;
+
+	const size_t full_words = size / 8;
+
+	for (size_t i = 0; i < full_words; i++)
+	{
+		uint64_t word;
+		std::memcpy(&word, data + i * 8, 8); // little endian hosts only, same as the binary format
+
+		v3 ^= word;
+		sip_round(v0, v1, v2, v3);
+		sip_round(v0, v1, v2, v3);
+		v0 ^= word;
+	}
+
+	// remaining bytes and the length in the top byte
+	uint64_t last = (uint64_t)size << 56;
+	for (size_t i = full_words * 8; i < size; i++)
+		last |= (uint64_t)(unsigned char)data[i] << (8 * (i - full_words * 8));
+
+	v3 ^= last;
+	sip_round(v0, v1, v2, v3);
+	sip_round(v0, v1, v2, v3);
+	v0 ^= last;
+
+	v2 ^= 0xff;
+	for (int i = 0; i < 4; i++)
+		sip_round(v0, v1, v2, v3);
+
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+matrix_hash hash_matrix(const CMatrix& matrix)
+{
+	// rows are hashed one by one so only one row is serialized at a time, their hashes are hashed together with the dimensions
+	std::vector<uint64_t> low_hashes = { matrix.get_row_count(), matrix.get_column_count() };
+	std::vector<uint64_t> high_hashes = low_hashes;
+	std::vector<char> buffer;
+
+	for (matrix_size row = 0; row < matrix.get_row_count(); row++)
+	{
+		buffer.clear();
+		CBinaryWriter writer(buffer);
+		writer.write_row(*matrix.get_row(row));
+
+		low_hashes.push_back(siphash(buffer.data(), buffer.size(), RESULT_CACHE_KEY_LOW_0, RESULT_CACHE_KEY_LOW_1));
+		high_hashes.push_back(siphash(buffer.data(), buffer.size(), RESULT_CACHE_KEY_HIGH_0, RESULT_CACHE_KEY_HIGH_1));
+	}
+
+	matrix_hash hash;
+	hash.low = siphash((const char*)low_hashes.data(), low_hashes.size() * sizeof(uint64_t), RESULT_CACHE_KEY_LOW_0, RESULT_CACHE_KEY_LOW_1);
+	hash.high = siphash((const char*)high_hashes.data(), high_hashes.size() * sizeof(uint64_t), RESULT_CACHE_KEY_HIGH_0, RESULT_CACHE_KEY_HIGH_1);
+	return hash;
+}
+
+CResultCache::CResultCache() : capacity(RESULT_CACHE_DEFAULT_ENTRIES), disk_limit(0), disk_usage(0), hit_count(0), disk_hit_count(0), miss_count(0)
+{
+}
+
+unsigned long long CResultCache::get_hit_count()
+{
+	std::lock_guard<std::mutex> lock(guard);
+	return hit_count;
+}
+
+unsigned long long CResultCache::get_disk_hit_count()
+{
+	std::lock_guard<std::mutex> lock(guard);
+	return disk_hit_count;
+}
+
+unsigned long long CResultCache::get_miss_count()
+{
+	std::lock_guard<std::mutex> lock(guard);
+	return miss_count;
+}
+
+void CResultCache::set_capacity(size_t capacity)
+{
+	std::lock_guard<std::mutex> lock(guard);
+	this->capacity = capacity;
+
+	while (entries.size() > capacity)
+	{
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+// space the file takes on the disk, 0 if it doesn't exist
+static unsigned long long get_file_disk_size(const std::string& path, time_t* last_use = nullptr)
+{
+	struct stat info;
+
+	if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+		return 0;
+
+	if (last_use)
+		*last_use = info.st_mtime;
+
+	return (unsigned long long)info.st_blocks * 512;
+}
+
+// entry files are named by matrix_hash::to_string, other files in the directory are not touched
+static bool parse_entry_name(const std::string& name, matrix_hash& key)
+{
+	const size_t extension_length = std::strlen(RESULT_CACHE_FILE_EXTENSION);
+
+	if (name.size() != 32 + extension_length || name.compare(32, extension_length, RESULT_CACHE_FILE_EXTENSION) != 0)
+		return false;
+
+	if (name.find_first_not_of("0123456789abcdef") < 32)
+		return false;
+
+	key.high = std::stoull(name.substr(0, 16), nullptr, 16);
+	key.low = std::stoull(name.substr(16, 16), nullptr, 16);
+	return true;
+}
+
+static std::string get_entry_path(const std::string& directory, const matrix_hash& key)
+{
+	return directory + "/" + key.to_string() + RESULT_CACHE_FILE_EXTENSION;
+}
+
+// returns the disk size of the entry file (for tracking), 0 if the entry can't be used
+static unsigned long long load_entry(const std::string& directory, const matrix_hash& key, matrix_member& determinant)
+{
+	const std::string path = get_entry_path(directory, key);
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+		return 0;
+
+	const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	// damaged entries (e.g. written by a different build) are just misses
+	try
+	{
+		CBinaryReader reader(data);
+
+		if (reader.read_value<uint32_t>() != RESULT_CACHE_MAGIC || reader.read_value<uint32_t>() != RESULT_CACHE_VERSION)
+			return 0;
+
+		if (reader.read_value<uint64_t>() != key.low || reader.read_value<uint64_t>() != key.high)
+			return 0;
+
+		determinant = reader.read_member();
+	}
+	catch (matrix_exception&)
+	{
+		return 0;
+	}
+
+	// modification time is the last use for the next run
+	::utime(path.c_str(), nullptr);
+	return get_file_disk_size(path);
+}
+
+// returns the disk size of the written entry file
+static unsigned long long save_entry(const std::string& directory, const matrix_hash& key, const matrix_member& determinant)
+{
+	static std::atomic<unsigned long long> temporary_counter(0);
+
+	std::vector<char> data;
+	CBinaryWriter writer(data);
+
+	writer.write_value<uint32_t>(RESULT_CACHE_MAGIC);
+	writer.write_value<uint32_t>(RESULT_CACHE_VERSION);
+	writer.write_value<uint64_t>(key.low);
+	writer.write_value<uint64_t>(key.high);
+	writer.write_member(determinant);
+
+	// written to a temporary file first, so a concurrent run never reads a half written entry
+	// the temporary name is unique per process and write, so concurrent writers of the same entry don't share it
+	const std::string path = get_entry_path(directory, key);
+	const std::string temporary_path = path + "." + std::to_string(::getpid()) + "." + std::to_string(temporary_counter++) + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), (std::streamsize)data.size());
+
+		if (!file)
+		{
+			file.close();
+			std::remove(temporary_path.c_str());
+			throw std::runtime_error("cannot write cache entry \"" + temporary_path + "\"");
+		}
+	}
+
+	if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+	{
+		std::remove(temporary_path.c_str());
+		throw std::runtime_error("cannot write cache entry \"" + path + "\"");
+	}
+
+	return get_file_disk_size(path);
+}
+
+// a file already removed by a different run doesn't take the space anymore either, so failures don't matter
+static void remove_files(const std::vector<std::string>& paths)
+{
+	for (const std::string& path : paths)
+		std::remove(path.c_str());
+}
+
+void CResultCache::set_directory(const std::string& directory, unsigned long long disk_limit)
+{
+	struct scanned_file
+	{
+		matrix_hash key;
+		unsigned long long size;
+		time_t last_use;
+	};
+
+	DIR* dir = ::opendir(directory.c_str());
+
+	if (!dir)
+		throw std::runtime_error("cache directory \"" + directory + "\" does not exist");
+
+	// the only scan of the directory, done before locking
+	std::vector<scanned_file> files;
+
+	while (dirent* item = ::readdir(dir))
+	{
+		scanned_file file;
+
+		if (!parse_entry_name(item->d_name, file.key))
+			continue;
+
+		file.size = get_file_disk_size(directory + "/" + item->d_name, &file.last_use);
+
+		if (file.size > 0)
+			files.push_back(file);
+	}
+
+	::closedir(dir);
+
+	std::sort(files.begin(), files.end(), [](const scanned_file& a, const scanned_file& b) { return a.last_use > b.last_use; });
+
+	std::vector<std::string> evicted_paths;
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		this->directory = directory;
+		this->disk_limit = disk_limit;
+
+		disk_entries.clear();
+		disk_index.clear();
+		disk_usage = 0;
+
+		for (const scanned_file& file : files)
+		{
+			disk_entries.push_back({ file.key, file.size });
+			disk_index[file.key] = std::prev(disk_entries.end());
+			disk_usage += file.size;
+		}
+
+		evicted_paths = evict_files();
+	}
+
+	remove_files(evicted_paths);
+}
+
+void CResultCache::insert(const matrix_hash& key, const matrix_member& determinant)
+{
+	auto position = index.find(key);
+
+	if (position != index.end())
+		entries.erase(position->second);
+
+	entries.push_front({ key, determinant });
+	index[key] = entries.begin();
+
+	while (entries.size() > capacity)
+	{
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+void CResultCache::track_file(const matrix_hash& key, unsigned long long size)
+{
+	auto position = disk_index.find(key);
+
+	// the file might have been written by a different run meanwhile, so it's not always known yet
+	if (position != disk_index.end())
+	{
+		disk_usage -= position->second->size;
+		disk_entries.erase(position->second);
+		disk_index.erase(position);
+	}
+
+	if (size == 0)
+		return;
+
+	disk_entries.push_front({ key, size });
+	disk_index[key] = disk_entries.begin();
+	disk_usage += size;
+}
+
+std::vector<std::string> CResultCache::evict_files()
+{
+	std::vector<std::string> paths;
+
+	while (disk_usage > disk_limit && !disk_entries.empty())
+	{
+		const disk_entry& entry = disk_entries.back();
+		paths.push_back(get_entry_path(directory, entry.key));
+
+		disk_usage -= entry.size;
+		disk_index.erase(entry.key);
+		disk_entries.pop_back();
+	}
+
+	return paths;
+}
+
+bool CResultCache::find(const matrix_hash& key, matrix_member& determinant)
+{
+	std::string directory;
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		auto position = index.find(key);
+
+		if (position != index.end())
+		{
+			entries.splice(entries.begin(), entries, position->second);
+			determinant = position->second->determinant;
+			hit_count++;
+			return true;
+		}
+
+		directory = this->directory;
+	}
+
+	// the file is read without holding the lock, so memory hits of other threads don't wait for the disk
+	matrix_member loaded;
+	const unsigned long long size = directory.empty() ? 0 : load_entry(directory, key, loaded);
+
+	std::lock_guard<std::mutex> lock(guard);
+
+	if (size == 0)
+	{
+		miss_count++;
+		return false;
+	}
+
+	determinant = loaded;
+	insert(key, determinant);
+
+	if (directory == this->directory)
+		track_file(key, size);
+
+	hit_count++;
+	disk_hit_count++;
+	return true;
+}
+
+void CResultCache::store(const matrix_hash& key, const matrix_member& determinant)
+{
+	std::string directory;
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		insert(key, determinant);
+		directory = this->directory;
+	}
+
+	if (directory.empty())
+		return;
+
+	// only the bookkeeping is done under the lock, writing and removing the files isn't
+	const unsigned long long size = save_entry(directory, key, determinant);
+	std::vector<std::string> evicted_paths;
+	{
+		std::lock_guard<std::mutex> lock(guard);
+
+		if (directory == this->directory)
+		{
+			track_file(key, size);
+			evicted_paths = evict_files();
+		}
+	}
+
+	remove_files(evicted_paths);
+}
@@ -0,0 +1,100 @@
+#ifndef _RESULT_CACHE_H_
+#define _RESULT_CACHE_H_
+
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+#include "Util.h"
+#include "Matrix.h"
+
+#define RESULT_CACHE_MAGIC 0x4352444dU // "MDRC"
+#define RESULT_CACHE_VERSION 1U
+#define RESULT_CACHE_DEFAULT_ENTRIES 4096 // determinants kept in memory
+#define RESULT_CACHE_DEFAULT_DISK_LIMIT (64ULL * 1024 * 1024)
+#define RESULT_CACHE_FILE_EXTENSION ".det"
+
+// 128-bit key, two SipHash-2-4 values of the same data with different keys
+struct matrix_hash
+{
+	uint64_t low;
+	uint64_t high;
+
+	bool operator==(const matrix_hash& other) const;
+	std::string to_string() const;
+};
+
+struct matrix_hash_hasher
+{
+	size_t operator()(const matrix_hash& hash) const;
+};
+
+uint64_t siphash(const char* data, size_t size, uint64_t key0, uint64_t key1);
+// hashes dimensions and the binary representation of all members (as written by CBinaryWriter)
+matrix_hash hash_matrix(const CMatrix& matrix);
+
+/*
+ * Determinants of already computed matrices, keyed by hash_matrix. Recently used entries are kept in memory,
+ * with a directory set every entry is also stored as a small file there, so results survive between runs.
+ * Both levels evict the least recently used entries - memory by entry count, the directory by disk space taken by the files.
+ * The directory is scanned once when it's set (file modification time is the last use), then its files are tracked in memory.
+ * Safe to be used from several threads, the files are read and written without holding the lock.
+ */
+class CResultCache
+{
+private:
+	struct cache_entry
+	{
+		matrix_hash key;
+		matrix_member determinant;
+	};
+
+	struct disk_entry
+	{
+		matrix_hash key;
+		unsigned long long size; // allocated blocks, not the length of the file
+	};
+
+	size_t capacity;
+	std::list<cache_entry> entries; // most recently used first
+	std::unordered_map<matrix_hash, std::list<cache_entry>::iterator, matrix_hash_hasher> index;
+
+	std::string directory;
+	unsigned long long disk_limit;
+	unsigned long long disk_usage;
+	std::list<disk_entry> disk_entries; // most recently used first
+	std::unordered_map<matrix_hash, std::list<disk_entry>::iterator, matrix_hash_hasher> disk_index;
+
+	unsigned long long hit_count;
+	unsigned long long disk_hit_count;
+	unsigned long long miss_count;
+
+	std::mutex guard;
+
+	// the members below are called with guard locked, they don't touch the files
+	void insert(const matrix_hash& key, const matrix_member& determinant);
+	// moves the file of key to the front of disk_entries with its size, size 0 means the file is gone
+	void track_file(const matrix_hash& key, unsigned long long size);
+	// drops the least recently used files over the limit, returns their paths to be removed after unlocking
+	std::vector<std::string> evict_files();
+
+public:
+	unsigned long long get_hit_count();
+	// hits served from the directory, included in get_hit_count
+	unsigned long long get_disk_hit_count();
+	unsigned long long get_miss_count();
+
+	void set_capacity(size_t capacity);
+	// directory has to exist, disk_limit is in bytes
+	void set_directory(const std::string& directory, unsigned long long disk_limit);
+
+	// returns false on a miss, determinant is not changed in that case
+	bool find(const matrix_hash& key, matrix_member& determinant);
+	void store(const matrix_hash& key, const matrix_member& determinant);
+
+	CResultCache();
+};
+#endif // !_RESULT_CACHE_H_
@@ -0,0 +1,372 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "ResultVerifier.h"
+
+#define VERIFY_PRIME_MIN (1ULL << 30)
+#define VERIFY_PRIME_MAX (1ULL << 31)
+
+static unsigned long long power_modulo(unsigned long long base, unsigned long long exponent, unsigned long long modulus)
+{
+	unsigned long long result = 1;
+	base %= modulus;
+
+	while (exponent > 0)
+	{
+		if (exponent & 1)
+			result = result * base % modulus;
+
+		base = base * base % modulus;
+		exponent >>= 1;
+	}
+
+	return result;
+}
+
+// value has to be integral and fit into long long
+static unsigned long long to_residue(const matrix_member& value, unsigned long long modulus)
+{
+	const long long residue = value.convert_to<long long>() % (long long)modulus;
+	return (unsigned long long)(residue < 0 ? residue + (long long)modulus : residue);
+}
+
+CResultVerifier::CResultVerifier(const CMatrix& source_matrix)
+	:
+	matrix(0, 0),
+	integer_matrix(true),
+	performed(false),
+	passed(false),
+	error_probability(1),
+	verification_time(0),
+	certified_determinant(0),
+	random(std::random_device()())
+{
+	time_value copy_start = get_current_time();
+
+	if (!is_matrix_square(source_matrix))
+		throw matrix_exception("only square matrices can be verified");
+
+	matrix = CDenseBlock(source_matrix);
+
+	// values have to fit into long long to be reduced modulo a prime
+	const matrix_member integer_limit = matrix_member(std::numeric_limits<long long>::max() / 2);
+
+	for (matrix_size row = 0; row < matrix.get_row_count() && integer_matrix; row++)
+		for (matrix_size column = 0; column < matrix.get_column_count() && integer_matrix; column++)
+			integer_matrix = matrix.at(row, column) == trunc(matrix.at(row, column)) && abs(matrix.at(row, column)) < integer_limit;
+
+	verification_time = time_diff(get_current_time(), copy_start);
+}
+
+bool CResultVerifier::is_performed() const
+{
+	return performed;
+}
+
+bool CResultVerifier::get_passed() const
+{
+	return passed;
+}
+
+double CResultVerifier::get_error_probability() const
+{
+	return error_probability;
+}
+
+const std::string& CResultVerifier::get_method() const
+{
+	return method;
+}
+
+millisecond_time_difference CResultVerifier::get_verification_time() const
+{
+	return verification_time;
+}
+
+const matrix_member& CResultVerifier::get_certified_determinant() const
+{
+	return certified_determinant;
+}
+
+bool CResultVerifier::is_integer_matrix() const
+{
+	return integer_matrix;
+}
+
+bool CResultVerifier::can_verify_modular(const matrix_member& determinant) const
+{
+	return integer_matrix && abs(determinant) < pow(matrix_member(10), std::numeric_limits<matrix_member>::digits10);
+}
+
+bool CResultVerifier::finish(bool passed, double error_probability, const std::string& method, time_value start)
+{
+	this->performed = true;
+	this->passed = passed;
+	this->error_probability = error_probability;
+	this->method = method;
+	this->verification_time += time_diff(get_current_time(), start);
+
+	return passed;
+}
+
+std::vector<matrix_member> CResultVerifier::get_random_probe()
+{
+	std::vector<matrix_member> probe(matrix.get_row_count());
+
+	for (matrix_member& value : probe)
+		value = (random() & 1) ? 1 : -1;
+
+	return probe;
+}
+
+std::vector<matrix_member> CResultVerifier::multiply(const std::vector<matrix_member>& vector, bool absolute) const
+{
+	std::vector<matrix_member> result(matrix.get_row_count(), matrix_member(0));
+
+	for (matrix_size row = 0; row < matrix.get_row_count(); row++)
+		for (matrix_size column = 0; column < matrix.get_column_count(); column++)
+			result[row] += (absolute ? abs(matrix.at(row, column)) : matrix.at(row, column)) * vector[column];
+
+	return result;
+}
+
+bool CResultVerifier::is_within_tolerance(const matrix_member& difference, const matrix_member& scale) const
+{
+	// usual backward error bound of gauss elimination - n * epsilon relative to the magnitudes involved
+	static const matrix_member epsilon = get_arithmetic_epsilon();
+	return abs(difference) <= VERIFY_TOLERANCE_FACTOR * matrix_member(matrix.get_row_count()) * epsilon * scale;
+}
+
+unsigned long long CResultVerifier::get_random_prime()
+{
+	std::uniform_int_distribution<unsigned long long> distribution(VERIFY_PRIME_MIN, VERIFY_PRIME_MAX - 1);
+
+	while (true)
+	{
+		const unsigned long long candidate = distribution(random) | 1;
+		bool prime = true;
+
+		for (unsigned long long divisor = 3; divisor * divisor <= candidate && prime; divisor += 2)
+			prime = candidate % divisor != 0;
+
+		if (prime)
+			return candidate;
+	}
+}
+
+unsigned long long CResultVerifier::get_determinant_modulo(unsigned long long prime) const
+{
+	const matrix_size size = matrix.get_row_count();
+	std::vector<unsigned long long> values((size_t)size * size);
+
+	for (matrix_size row = 0; row < size; row++)
+		for (matrix_size column = 0; column < size; column++)
+			values[(size_t)row * size + column] = to_residue(matrix.at(row, column), prime);
+
+	unsigned long long determinant = 1;
+
+	for (matrix_size pivot = 0; pivot < size; pivot++)
+	{
+		matrix_size pivot_row = pivot;
+
+		while (pivot_row < size && values[(size_t)pivot_row * size + pivot] == 0)
+			pivot_row++;
+
+		if (pivot_row == size)
+			return 0;
+
+		if (pivot_row != pivot)
+		{
+			std::swap_ranges(values.begin() + (size_t)pivot * size, values.begin() + (size_t)(pivot + 1) * size, values.begin() + (size_t)pivot_row * size);
+			determinant = prime - determinant;
+		}
+
+		const unsigned long long div = values[(size_t)pivot * size + pivot];
+		const unsigned long long inverse = power_modulo(div, prime - 2, prime);
+		determinant = determinant * div % prime;
+
+		for (matrix_size row = pivot + 1; row < size; row++)
+		{
+			const unsigned long long coef = values[(size_t)row * size + pivot] * inverse % prime;
+
+			if (coef == 0)
+				continue;
+
+			for (matrix_size column = pivot; column < size; column++)
+			{
+				unsigned long long& value = values[(size_t)row * size + column];
+				value = (value + prime - coef * values[(size_t)pivot * size + column] % prime) % prime;
+			}
+		}
+	}
+
+	return determinant % prime;
+}
+
+bool CResultVerifier::verify_modular(const matrix_member& determinant)
+{
+	time_value start = get_current_time();
+
+	if (!can_verify_modular(determinant))
+		throw matrix_exception("determinant cannot be verified modulo primes");
+
+	const matrix_member rounded = round(determinant);
+
+	// |true - computed| is bounded by hadamard bound + |computed|, such number has at most bits / 30 prime factors above 2^30
+	double bits = std::numeric_limits<matrix_member>::digits10 * std::log2(10.0);
+
+	for (matrix_size row = 0; row < matrix.get_row_count(); row++)
+	{
+		double row_norm = 0;
+
+		for (matrix_size column = 0; column < matrix.get_column_count(); column++)
+			row_norm += std::pow(matrix.at(row, column).convert_to<double>(), 2);
+
+		if (row_norm > 0)
+			bits += 0.5 * std::log2(row_norm);
+	}
+
+	const double prime_factors = std::ceil((bits + 1) / 30);
+	const double primes_in_range = (double)(VERIFY_PRIME_MAX - VERIFY_PRIME_MIN) / std::log((double)VERIFY_PRIME_MAX);
+	const double miss_probability = std::min(prime_factors / primes_in_range, 1.0);
+
+	// rounding errors of the elimination can be far above the arithmetic precision, so the nearest integer is taken as the candidate
+	// and the primes check whether it is the determinant - if they do, the candidate is the result, not the computed value
+	bool matches = true;
+
+	for (unsigned int i = 0; i < VERIFY_PRIME_COUNT && matches; i++)
+	{
+		const unsigned long long prime = get_random_prime();
+		matches = get_determinant_modulo(prime) == to_residue(rounded, prime);
+	}
+
+	if (matches)
+		certified_determinant = rounded;
+
+	return finish(matches, std::pow(miss_probability, VERIFY_PRIME_COUNT), "determinant modulo " + std::to_string(VERIFY_PRIME_COUNT) + " random primes", start);
+}
+
+bool CResultVerifier::verify_elimination(const CMatrix& eliminated, const CEliminationLog& log)
+{
+	time_value start = get_current_time();
+	const matrix_size size = matrix.get_row_count();
+	const std::string name = "elimination residual with " + std::to_string(VERIFY_PROBE_COUNT) + " random probes";
+
+	if (eliminated.get_row_count() != size || eliminated.get_column_count() != size)
+		throw matrix_exception("eliminated matrix doesn't match the original one");
+
+	// swaps are the only operations changing the determinant
+	if ((log.get_swap_count() % 2 == 0 ? 1 : -1) != eliminated.get_swap_coefficient())
+		return finish(false, 0, name, start);
+
+	// computes U * vector
+	auto multiply_eliminated = [&eliminated, size](const std::vector<matrix_member>& vector, bool absolute)
+	{
+		std::vector<matrix_member> result(size, matrix_member(0));
+
+		for (matrix_size row = 0; row < size; row++)
+		{
+			const CMatrixRow* eliminated_row = eliminated.get_row(row);
+
+			for (matrix_size column = 0; column < size; column++)
+				result[row] += (absolute ? abs(eliminated_row->get_column(column)) : eliminated_row->get_column(column)) * vector[column];
+		}
+
+		return result;
+	};
+
+	// magnitudes of both sides for the probes of +-1, the same for every probe
+	const std::vector<matrix_member> ones(size, matrix_member(1));
+	std::vector<matrix_member> scale = multiply_eliminated(ones, true);
+	log.undo_absolute(scale);
+
+	const std::vector<matrix_member> original_scale = multiply(ones, true);
+	matrix_member largest_scale = 0;
+
+	for (matrix_size row = 0; row < size; row++)
+	{
+		scale[row] += original_scale[row];
+		largest_scale = std::max(largest_scale, scale[row]);
+	}
+
+	// the determinant is taken from the diagonal, so whatever is left below it has to be rounding noise
+	for (matrix_size row = 1; row < size; row++)
+		for (matrix_size column = 0; column < row; column++)
+			if (!is_within_tolerance(eliminated.get_value(row, column), largest_scale))
+				return finish(false, 0, name, start);
+
+	for (unsigned int probe_index = 0; probe_index < VERIFY_PROBE_COUNT; probe_index++)
+	{
+		const std::vector<matrix_member> probe = get_random_probe();
+
+		std::vector<matrix_member> restored = multiply_eliminated(probe, false);
+		log.undo(restored);
+
+		const std::vector<matrix_member> original = multiply(probe, false);
+
+		for (matrix_size row = 0; row < size; row++)
+			if (!is_within_tolerance(original[row] - restored[row], scale[row]))
+				return finish(false, 0, name, start);
+	}
+
+	return finish(true, std::pow(0.5, VERIFY_PROBE_COUNT), name, start);
+}
+
+bool CResultVerifier::verify_factorization(const CDenseBlock& factors, const std::vector<matrix_size>& pivots)
+{
+	time_value start = get_current_time();
+	const matrix_size size = matrix.get_row_count();
+
+	if (factors.get_row_count() != size || factors.get_column_count() != size || pivots.size() != size)
+		throw matrix_exception("factorization doesn't match the original matrix");
+
+	// computes L * U * vector
+	auto multiply_factors = [&factors, size](const std::vector<matrix_member>& vector, bool absolute)
+	{
+		std::vector<matrix_member> upper(size, matrix_member(0));
+
+		for (matrix_size row = 0; row < size; row++)
+			for (matrix_size column = row; column < size; column++)
+				upper[row] += (absolute ? abs(factors.at(row, column)) : factors.at(row, column)) * vector[column];
+
+		std::vector<matrix_member> result(upper);
+
+		for (matrix_size row = 1; row < size; row++)
+			for (matrix_size column = 0; column < row; column++)
+				result[row] += (absolute ? abs(factors.at(row, column)) : factors.at(row, column)) * upper[column];
+
+		return result;
+	};
+
+	auto permute = [&pivots, size](std::vector<matrix_member>& vector)
+	{
+		for (matrix_size row = 0; row < size; row++)
+			std::swap(vector[row], vector[pivots[row]]);
+	};
+
+	const std::vector<matrix_member> ones(size, matrix_member(1));
+	std::vector<matrix_member> scale = multiply(ones, true);
+	permute(scale);
+
+	const std::vector<matrix_member> factors_scale = multiply_factors(ones, true);
+
+	for (matrix_size row = 0; row < size; row++)
+		scale[row] += factors_scale[row];
+
+	for (unsigned int probe_index = 0; probe_index < VERIFY_PROBE_COUNT; probe_index++)
+	{
+		const std::vector<matrix_member> probe = get_random_probe();
+
+		std::vector<matrix_member> permuted = multiply(probe, false);
+		permute(permuted);
+
+		const std::vector<matrix_member> factorized = multiply_factors(probe, false);
+
+		for (matrix_size row = 0; row < size; row++)
+			if (!is_within_tolerance(permuted[row] - factorized[row], scale[row]))
+				return finish(false, 0, "LU residual", start);
+	}
+
+	return finish(true, std::pow(0.5, VERIFY_PROBE_COUNT), "LU residual with " + std::to_string(VERIFY_PROBE_COUNT) + " random probes", start);
+}
@@ -0,0 +1,70 @@
+#ifndef _RESULT_VERIFIER_H_
+#define _RESULT_VERIFIER_H_
+
+#include <string>
+#include <vector>
+#include <random>
+
+#include "Util.h"
+#include "Matrix.h"
+#include "MatrixUtils.h"
+#include "StrassenSchurDeterminant.h"
+
+#define VERIFY_PRIME_COUNT 4
+#define VERIFY_PROBE_COUNT 10
+#define VERIFY_TOLERANCE_FACTOR 16
+
+/*
+ * Checks a computed determinant without computing it again in multiprecision.
+ * Integer matrices whose determinant is small enough to be exact are checked by computing the determinant modulo
+ * random 31-bit primes in machine integers. Otherwise the factorization done by the engine is checked by multiplying
+ * both sides with random +-1 vectors (Freivalds), which is O(n^2) per probe. Every probe misses a residual
+ * above the rounding tolerance with probability at most 1/2.
+ */
+class CResultVerifier
+{
+private:
+	CDenseBlock matrix; // original matrix
+	bool integer_matrix;
+
+	bool performed;
+	bool passed;
+	double error_probability;
+	std::string method;
+	millisecond_time_difference verification_time;
+	matrix_member certified_determinant;
+
+	std::mt19937_64 random;
+
+	std::vector<matrix_member> get_random_probe();
+	std::vector<matrix_member> multiply(const std::vector<matrix_member>& vector, bool absolute) const;
+	bool is_within_tolerance(const matrix_member& difference, const matrix_member& scale) const;
+	unsigned long long get_random_prime();
+	unsigned long long get_determinant_modulo(unsigned long long prime) const;
+
+	bool finish(bool passed, double error_probability, const std::string& method, time_value start);
+
+public:
+	bool is_performed() const;
+	bool get_passed() const;
+	// upper bound of the probability that a wrong result passed
+	double get_error_probability() const;
+	const std::string& get_method() const;
+	millisecond_time_difference get_verification_time() const;
+	// exact determinant confirmed by a passed verify_modular, the computed one rounded to the nearest integer
+	const matrix_member& get_certified_determinant() const;
+
+	bool is_integer_matrix() const;
+	// modular check needs an integer matrix and a determinant that matrix_member represents exactly
+	bool can_verify_modular(const matrix_member& determinant) const;
+
+	// checks the integer nearest to determinant, which is available from get_certified_determinant if it passes
+	bool verify_modular(const matrix_member& determinant);
+	// eliminated matrix has to be the original one with all operations of log applied, its diagonal gives the determinant
+	bool verify_elimination(const CMatrix& eliminated, const CEliminationLog& log);
+	// P * A = L * U, L is unit lower triangular stored below the diagonal of factors, U is stored on and above it
+	bool verify_factorization(const CDenseBlock& factors, const std::vector<matrix_size>& pivots);
+
+	CResultVerifier(const CMatrix& source_matrix);
+};
+#endif // !_RESULT_VERIFIER_H_
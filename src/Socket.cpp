@@ -0,0 +1,364 @@
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <chrono>
+
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "Socket.h"
+#include "Util.h"
+
+#define SOCKET_LISTEN_BACKLOG 64
+#define SOCKET_CONNECT_RETRY_MS 50
+
+socket_exception::socket_exception(const std::string& message) : std::runtime_error(message)
+{
+}
+
+static std::string describe_errno(const std::string& message)
+{
+	return message + ": " + std::strerror(errno);
+}
+
+static bool is_unix_address(const std::string& address)
+{
+	return address.compare(0, 5, "unix:") == 0;
+}
+
+static sockaddr_un get_unix_address(const std::string& address)
+{
+	const std::string path = address.substr(5);
+	sockaddr_un unix_address;
+	std::memset(&unix_address, 0, sizeof(unix_address));
+
+	if (path.empty() || path.size() >= sizeof(unix_address.sun_path))
+		throw socket_exception("invalid unix socket path \"" + path + "\"");
+
+	unix_address.sun_family = AF_UNIX;
+	std::strcpy(unix_address.sun_path, path.c_str());
+	return unix_address;
+}
+
+// resolves "HOST:PORT", empty HOST means any local address when listening
+static addrinfo* get_tcp_address(const std::string& address, bool listening)
+{
+	const size_t separator = address.rfind(':');
+
+	if (separator == std::string::npos)
+		throw socket_exception("invalid address \"" + address + "\", expected unix:PATH or HOST:PORT");
+
+	const std::string host = address.substr(0, separator);
+	const std::string port = address.substr(separator + 1);
+
+	addrinfo hints;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if (listening)
+		hints.ai_flags = AI_PASSIVE;
+
+	addrinfo* result = nullptr;
+	const int error = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result);
+
+	if (error != 0)
+		throw socket_exception("cannot resolve \"" + address + "\": " + gai_strerror(error));
+
+	return result;
+}
+
+CSocket::CSocket(int descriptor) : descriptor(descriptor)
+{
+}
+
+CSocket::CSocket(CSocket&& original) : descriptor(original.descriptor)
+{
+	original.descriptor = -1;
+}
+
+CSocket::~CSocket()
+{
+	close();
+}
+
+CSocket& CSocket::operator=(CSocket&& other)
+{
+	if (this != &other)
+	{
+		close();
+		descriptor = other.descriptor;
+		other.descriptor = -1;
+	}
+
+	return (*this);
+}
+
+int CSocket::get_descriptor() const
+{
+	return descriptor;
+}
+
+bool CSocket::is_open() const
+{
+	return descriptor >= 0;
+}
+
+void CSocket::close()
+{
+	if (descriptor >= 0)
+	{
+		::close(descriptor);
+		descriptor = -1;
+	}
+}
+
+void CSocket::send_all(const void* data, size_t size)
+{
+	const char* bytes = static_cast<const char*>(data);
+
+	while (size > 0)
+	{
+		// MSG_NOSIGNAL - closed peer is reported as an error instead of killing the process with SIGPIPE
+		const ssize_t sent = ::send(descriptor, bytes, size, MSG_NOSIGNAL);
+
+		if (sent < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			throw socket_exception(describe_errno("send failed"));
+		}
+
+		bytes += sent;
+		size -= (size_t)sent;
+	}
+}
+
+bool CSocket::receive_all(void* data, size_t size)
+{
+	char* bytes = static_cast<char*>(data);
+	size_t received_total = 0;
+
+	while (received_total < size)
+	{
+		const ssize_t received = ::recv(descriptor, bytes + received_total, size - received_total, 0);
+
+		if (received < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			throw socket_exception(describe_errno("receive failed"));
+		}
+
+		if (received == 0)
+		{
+			if (received_total == 0)
+				return false;
+
+			throw socket_exception("connection closed in the middle of a message");
+		}
+
+		received_total += (size_t)received;
+	}
+
+	return true;
+}
+
+size_t CSocket::receive_some(void* data, size_t max_size)
+{
+	while (true)
+	{
+		const ssize_t received = ::recv(descriptor, data, max_size, 0);
+
+		if (received >= 0)
+			return (size_t)received;
+
+		if (errno != EINTR)
+			throw socket_exception(describe_errno("receive failed"));
+	}
+}
+
+void CSocket::send_message(const std::vector<char>& message)
+{
+	const uint64_t size = message.size();
+	send_all(&size, sizeof(size));
+	send_all(message.data(), message.size());
+}
+
+bool CSocket::receive_message(std::vector<char>& message, size_t max_size)
+{
+	uint64_t size;
+
+	if (!receive_all(&size, sizeof(size)))
+		return false;
+
+	// the length comes from the peer
+	if (size > max_size)
+		throw socket_exception("message of " + std::to_string(size) + " bytes exceeds the limit of " + std::to_string(max_size) + " bytes");
+
+	message.resize((size_t)size);
+
+	if (size > 0 && !receive_all(message.data(), message.size()))
+		throw socket_exception("connection closed in the middle of a message");
+
+	return true;
+}
+
+CSocket CSocket::connect_to(const std::string& address)
+{
+	if (is_unix_address(address))
+	{
+		const sockaddr_un unix_address = get_unix_address(address);
+		CSocket connection(::socket(AF_UNIX, SOCK_STREAM, 0));
+
+		if (!connection.is_open())
+			throw socket_exception(describe_errno("cannot create socket"));
+
+		if (::connect(connection.get_descriptor(), (const sockaddr*)&unix_address, sizeof(unix_address)) != 0)
+			throw socket_exception(describe_errno("cannot connect to \"" + address + "\""));
+
+		return connection;
+	}
+
+	addrinfo* addresses = get_tcp_address(address, false);
+	std::string error = "cannot connect to \"" + address + "\"";
+
+	for (addrinfo* current = addresses; current; current = current->ai_next)
+	{
+		CSocket connection(::socket(current->ai_family, current->ai_socktype, current->ai_protocol));
+
+		if (!connection.is_open())
+			continue;
+
+		if (::connect(connection.get_descriptor(), current->ai_addr, current->ai_addrlen) == 0)
+		{
+			// messages are small and latency bound
+			const int enabled = 1;
+			setsockopt(connection.get_descriptor(), IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+
+			freeaddrinfo(addresses);
+			return connection;
+		}
+
+		error = describe_errno("cannot connect to \"" + address + "\"");
+	}
+
+	freeaddrinfo(addresses);
+	throw socket_exception(error);
+}
+
+CSocket CSocket::connect_to(const std::string& address, unsigned int timeout_ms)
+{
+	time_value start = get_current_time();
+
+	while (true)
+	{
+		try
+		{
+			return connect_to(address);
+		}
+		catch (socket_exception&)
+		{
+			if (time_diff(get_current_time(), start) >= (millisecond_time_difference)timeout_ms)
+				throw;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(SOCKET_CONNECT_RETRY_MS));
+	}
+}
+
+CListeningSocket::CListeningSocket(const std::string& address) : descriptor(-1)
+{
+	if (is_unix_address(address))
+	{
+		const sockaddr_un unix_address = get_unix_address(address);
+		descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if (descriptor < 0)
+			throw socket_exception(describe_errno("cannot create socket"));
+
+		::unlink(unix_address.sun_path); // remove stale socket file left by a previous run
+
+		if (::bind(descriptor, (const sockaddr*)&unix_address, sizeof(unix_address)) != 0)
+		{
+			const std::string error = describe_errno("cannot bind \"" + address + "\"");
+			::close(descriptor);
+			throw socket_exception(error);
+		}
+
+		unix_path = unix_address.sun_path;
+	}
+	else
+	{
+		addrinfo* addresses = get_tcp_address(address, true);
+
+		for (addrinfo* current = addresses; current && descriptor < 0; current = current->ai_next)
+		{
+			descriptor = ::socket(current->ai_family, current->ai_socktype, current->ai_protocol);
+
+			if (descriptor < 0)
+				continue;
+
+			const int enabled = 1;
+			setsockopt(descriptor, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+
+			if (::bind(descriptor, current->ai_addr, current->ai_addrlen) != 0)
+			{
+				::close(descriptor);
+				descriptor = -1;
+			}
+		}
+
+		freeaddrinfo(addresses);
+
+		if (descriptor < 0)
+			throw socket_exception(describe_errno("cannot bind \"" + address + "\""));
+	}
+
+	if (::listen(descriptor, SOCKET_LISTEN_BACKLOG) != 0)
+	{
+		const std::string error = describe_errno("cannot listen on \"" + address + "\"");
+		::close(descriptor);
+		throw socket_exception(error);
+	}
+}
+
+CListeningSocket::~CListeningSocket()
+{
+	::close(descriptor);
+
+	if (!unix_path.empty())
+		::unlink(unix_path.c_str());
+}
+
+int CListeningSocket::get_descriptor() const
+{
+	return descriptor;
+}
+
+CSocket CListeningSocket::accept_connection()
+{
+	while (true)
+	{
+		const int connection = ::accept(descriptor, nullptr, nullptr);
+
+		if (connection >= 0)
+		{
+			// fails harmlessly for unix domain sockets
+			const int enabled = 1;
+			setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+
+			return CSocket(connection);
+		}
+
+		if (errno != EINTR)
+			throw socket_exception(describe_errno("accept failed"));
+	}
+}
@@ -0,0 +1,66 @@
+#ifndef _SOCKET_H_
+#define _SOCKET_H_
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#define SOCKET_DEFAULT_MAX_MESSAGE_SIZE (1ULL << 30) // receive_message limit unless the caller knows a tighter one
+
+class socket_exception : public std::runtime_error
+{
+public:
+	socket_exception(const std::string& message);
+};
+
+/*
+ * Connected stream socket. Addresses are either "unix:PATH" for unix domain sockets or "HOST:PORT" for TCP.
+ * Messages sent by send_message are prefixed with their length so they can be received as a whole by receive_message.
+ */
+class CSocket
+{
+private:
+	int descriptor;
+
+public:
+	int get_descriptor() const;
+	bool is_open() const;
+	void close();
+
+	void send_all(const void* data, size_t size);
+	// returns false if the connection was closed before any data was received
+	bool receive_all(void* data, size_t size);
+	// receives whatever is available (waits for at least one byte), returns 0 if the connection was closed
+	size_t receive_some(void* data, size_t max_size);
+
+	void send_message(const std::vector<char>& message);
+	// returns false if the connection was closed before the message started, messages announced longer than max_size are rejected before allocating
+	bool receive_message(std::vector<char>& message, size_t max_size = SOCKET_DEFAULT_MAX_MESSAGE_SIZE);
+
+	static CSocket connect_to(const std::string& address);
+	// retries until the remote side starts listening or timeout_ms passes
+	static CSocket connect_to(const std::string& address, unsigned int timeout_ms);
+
+	CSocket& operator=(CSocket&& other);
+
+	CSocket(const CSocket& original) = delete;
+	CSocket(CSocket&& original);
+	explicit CSocket(int descriptor);
+	~CSocket();
+};
+
+class CListeningSocket
+{
+private:
+	int descriptor;
+	std::string unix_path;
+
+public:
+	int get_descriptor() const;
+	CSocket accept_connection();
+
+	CListeningSocket(const CListeningSocket& original) = delete;
+	CListeningSocket(const std::string& address);
+	~CListeningSocket();
+};
+#endif // !_SOCKET_H_
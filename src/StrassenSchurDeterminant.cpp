@@ -0,0 +1,482 @@
+#include <algorithm>
+#include <utility>
+
+#include "StrassenSchurDeterminant.h"
+#include "MatrixUtils.h"
+#include "Util.h"
+
+#define CLASSIC_MULTIPLY_BLOCK_SIZE 32
+
+// thrown when a leading block cannot be inverted, the engine falls back to plain GEM in that case
+class singular_block_exception : public matrix_exception
+{
+public:
+	singular_block_exception() : matrix_exception("singular leading block") {}
+};
+
+CDenseBlock::CDenseBlock(matrix_size rows, matrix_size columns) : row_count(rows), column_count(columns), values((size_t)rows * columns, matrix_member(0))
+{
+}
+
+CDenseBlock::CDenseBlock(const CMatrix& matrix) : CDenseBlock(matrix.get_row_count(), matrix.get_column_count())
+{
+	for (matrix_size row = 0; row < row_count; row++)
+	{
+		const CMatrixRow* matrix_row = matrix.get_row(row);
+
+		for (matrix_size column = 0; column < column_count; column++)
+			at(row, column) = matrix_row->get_column(column);
+	}
+}
+
+CDenseBlock::CDenseBlock(CMatrix&& matrix) : row_count(matrix.get_row_count()), column_count(matrix.get_column_count())
+{
+	// only reserved, the memory is filled row by row while the source rows are released
+	values.reserve((size_t)row_count * column_count);
+
+	for (matrix_size row = 0; row < row_count; row++)
+	{
+		const CMatrixRow* matrix_row = matrix.get_row(row);
+
+		for (matrix_size column = 0; column < column_count; column++)
+			values.push_back(matrix_row->get_column(column));
+
+		matrix.set_row(row, new CMatrixRow(0));
+	}
+}
+
+CMatrix CDenseBlock::to_matrix() const
+{
+	CMatrix matrix(row_count, column_count);
+
+	for (matrix_size row = 0; row < row_count; row++)
+	{
+		CMatrixRow* matrix_row = matrix.get_row(row);
+
+		for (matrix_size column = 0; column < column_count; column++)
+			matrix_row->set_value(column, at(row, column));
+	}
+
+	return matrix;
+}
+
+matrix_size CDenseBlock::get_row_count() const
+{
+	return row_count;
+}
+
+matrix_size CDenseBlock::get_column_count() const
+{
+	return column_count;
+}
+
+matrix_member& CDenseBlock::at(matrix_size row, matrix_size column)
+{
+	return values[(size_t)row * column_count + column];
+}
+
+const matrix_member& CDenseBlock::at(matrix_size row, matrix_size column) const
+{
+	return values[(size_t)row * column_count + column];
+}
+
+CDenseBlock CDenseBlock::get_block(matrix_size first_row, matrix_size first_column, matrix_size rows, matrix_size columns) const
+{
+	CDenseBlock block(rows, columns);
+
+	const matrix_size copied_rows = first_row < row_count ? std::min(rows, row_count - first_row) : 0;
+	const matrix_size copied_columns = first_column < column_count ? std::min(columns, column_count - first_column) : 0;
+
+	for (matrix_size row = 0; row < copied_rows; row++)
+		for (matrix_size column = 0; column < copied_columns; column++)
+			block.at(row, column) = at(first_row + row, first_column + column);
+
+	return block;
+}
+
+void CDenseBlock::set_block(matrix_size first_row, matrix_size first_column, const CDenseBlock& source)
+{
+	const matrix_size copied_rows = first_row < row_count ? std::min(source.get_row_count(), row_count - first_row) : 0;
+	const matrix_size copied_columns = first_column < column_count ? std::min(source.get_column_count(), column_count - first_column) : 0;
+
+	for (matrix_size row = 0; row < copied_rows; row++)
+		for (matrix_size column = 0; column < copied_columns; column++)
+			at(first_row + row, first_column + column) = source.at(row, column);
+}
+
+CDenseBlock& CDenseBlock::operator+=(const CDenseBlock& other)
+{
+	if (other.get_row_count() != row_count || other.get_column_count() != column_count)
+		throw matrix_exception("adding blocks of different sizes");
+
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] += other.values[i];
+
+	return (*this);
+}
+
+CDenseBlock& CDenseBlock::operator-=(const CDenseBlock& other)
+{
+	if (other.get_row_count() != row_count || other.get_column_count() != column_count)
+		throw matrix_exception("subtracting blocks of different sizes");
+
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] -= other.values[i];
+
+	return (*this);
+}
+
+CDenseBlock operator+(const CDenseBlock& block, const CDenseBlock& other)
+{
+	CDenseBlock result(block);
+	result += other;
+	return result;
+}
+
+CDenseBlock operator-(const CDenseBlock& block, const CDenseBlock& other)
+{
+	CDenseBlock result(block);
+	result -= other;
+	return result;
+}
+
+CDenseBlock classic_multiply(const CDenseBlock& a, const CDenseBlock& b)
+{
+	if (a.get_column_count() != b.get_row_count())
+		throw matrix_exception("multiplying blocks of incompatible sizes");
+
+	const matrix_size rows = a.get_row_count();
+	const matrix_size inner = a.get_column_count();
+	const matrix_size columns = b.get_column_count();
+	CDenseBlock result(rows, columns);
+
+	// i-k-j order inside of cache sized tiles, innermost loop walks both b and result row-wise
+	for (matrix_size ii = 0; ii < rows; ii += CLASSIC_MULTIPLY_BLOCK_SIZE)
+		for (matrix_size kk = 0; kk < inner; kk += CLASSIC_MULTIPLY_BLOCK_SIZE)
+			for (matrix_size jj = 0; jj < columns; jj += CLASSIC_MULTIPLY_BLOCK_SIZE)
+			{
+				const matrix_size i_end = std::min(ii + CLASSIC_MULTIPLY_BLOCK_SIZE, rows);
+				const matrix_size k_end = std::min(kk + CLASSIC_MULTIPLY_BLOCK_SIZE, inner);
+				const matrix_size j_end = std::min(jj + CLASSIC_MULTIPLY_BLOCK_SIZE, columns);
+
+				for (matrix_size i = ii; i < i_end; i++)
+					for (matrix_size k = kk; k < k_end; k++)
+					{
+						const matrix_member& a_ik = a.at(i, k);
+
+						if (a_ik == 0)
+							continue;
+
+						for (matrix_size j = jj; j < j_end; j++)
+							result.at(i, j) += a_ik * b.at(k, j);
+					}
+			}
+
+	return result;
+}
+
+CDenseBlock strassen_multiply(const CDenseBlock& a, const CDenseBlock& b, matrix_size cutoff)
+{
+	if (a.get_column_count() != b.get_row_count())
+		throw matrix_exception("multiplying blocks of incompatible sizes");
+
+	const matrix_size rows = a.get_row_count();
+	const matrix_size inner = a.get_column_count();
+	const matrix_size columns = b.get_column_count();
+
+	if (rows <= cutoff || inner <= cutoff || columns <= cutoff)
+		return classic_multiply(a, b);
+
+	// odd dimensions are padded with zeros by get_block
+	const matrix_size half_rows = (rows + 1) / 2;
+	const matrix_size half_inner = (inner + 1) / 2;
+	const matrix_size half_columns = (columns + 1) / 2;
+
+	const CDenseBlock a11 = a.get_block(0, 0, half_rows, half_inner);
+	const CDenseBlock a12 = a.get_block(0, half_inner, half_rows, half_inner);
+	const CDenseBlock a21 = a.get_block(half_rows, 0, half_rows, half_inner);
+	const CDenseBlock a22 = a.get_block(half_rows, half_inner, half_rows, half_inner);
+
+	const CDenseBlock b11 = b.get_block(0, 0, half_inner, half_columns);
+	const CDenseBlock b12 = b.get_block(0, half_columns, half_inner, half_columns);
+	const CDenseBlock b21 = b.get_block(half_inner, 0, half_inner, half_columns);
+	const CDenseBlock b22 = b.get_block(half_inner, half_columns, half_inner, half_columns);
+
+	// Winograd variant - 7 multiplications and 15 additions
+	const CDenseBlock s1 = a21 + a22;
+	const CDenseBlock s2 = s1 - a11;
+	const CDenseBlock s3 = a11 - a21;
+	const CDenseBlock s4 = a12 - s2;
+
+	const CDenseBlock t1 = b12 - b11;
+	const CDenseBlock t2 = b22 - t1;
+	const CDenseBlock t3 = b22 - b12;
+	const CDenseBlock t4 = t2 - b21;
+
+	const CDenseBlock m1 = strassen_multiply(a11, b11, cutoff);
+	const CDenseBlock m2 = strassen_multiply(a12, b21, cutoff);
+	const CDenseBlock m3 = strassen_multiply(s4, b22, cutoff);
+	const CDenseBlock m4 = strassen_multiply(a22, t4, cutoff);
+	const CDenseBlock m5 = strassen_multiply(s1, t1, cutoff);
+	const CDenseBlock m6 = strassen_multiply(s2, t2, cutoff);
+	const CDenseBlock m7 = strassen_multiply(s3, t3, cutoff);
+
+	const CDenseBlock u2 = m1 + m6;
+	const CDenseBlock u3 = u2 + m7;
+	const CDenseBlock u4 = u2 + m5;
+
+	CDenseBlock result(rows, columns);
+	result.set_block(0, 0, m1 + m2);
+	result.set_block(0, half_columns, u4 + m3);
+	result.set_block(half_rows, 0, u3 - m4);
+	result.set_block(half_rows, half_columns, u3 + m5);
+
+	return result;
+}
+
+// gauss elimination with partial pivoting, used for blocks that are not above the cutoff
+static matrix_member base_determinant(CDenseBlock block)
+{
+	const matrix_size size = block.get_row_count();
+	matrix_member determinant = 1;
+
+	for (matrix_size i = 0; i < size; i++)
+	{
+		matrix_size pivot = i;
+
+		for (matrix_size row = i + 1; row < size; row++)
+			if (abs(block.at(row, i)) > abs(block.at(pivot, i)))
+				pivot = row;
+
+		if (block.at(pivot, i) == 0)
+			return 0;
+
+		if (pivot != i)
+		{
+			for (matrix_size column = i; column < size; column++)
+				std::swap(block.at(i, column), block.at(pivot, column));
+
+			determinant = -determinant;
+		}
+
+		const matrix_member& div = block.at(i, i);
+		determinant *= div;
+
+		for (matrix_size row = i + 1; row < size; row++)
+		{
+			const matrix_member coef = block.at(row, i) / div;
+
+			if (coef == 0)
+				continue;
+
+			for (matrix_size column = i; column < size; column++)
+				block.at(row, column) -= block.at(i, column) * coef;
+		}
+	}
+
+	return determinant;
+}
+
+// gauss-jordan elimination with partial pivoting, returns determinant and stores the inverse
+static matrix_member base_inverse(CDenseBlock block, CDenseBlock& inverse)
+{
+	const matrix_size size = block.get_row_count();
+	matrix_member determinant = 1;
+
+	inverse = CDenseBlock(size, size);
+	for (matrix_size i = 0; i < size; i++)
+		inverse.at(i, i) = 1;
+
+	for (matrix_size i = 0; i < size; i++)
+	{
+		matrix_size pivot = i;
+
+		for (matrix_size row = i + 1; row < size; row++)
+			if (abs(block.at(row, i)) > abs(block.at(pivot, i)))
+				pivot = row;
+
+		if (block.at(pivot, i) == 0)
+			throw singular_block_exception();
+
+		if (pivot != i)
+		{
+			for (matrix_size column = 0; column < size; column++)
+			{
+				std::swap(block.at(i, column), block.at(pivot, column));
+				std::swap(inverse.at(i, column), inverse.at(pivot, column));
+			}
+
+			determinant = -determinant;
+		}
+
+		const matrix_member div = block.at(i, i);
+		determinant *= div;
+
+		for (matrix_size column = 0; column < size; column++)
+		{
+			block.at(i, column) /= div;
+			inverse.at(i, column) /= div;
+		}
+
+		for (matrix_size row = 0; row < size; row++)
+		{
+			if (row == i || block.at(row, i) == 0)
+				continue;
+
+			const matrix_member coef = block.at(row, i);
+
+			for (matrix_size column = 0; column < size; column++)
+			{
+				block.at(row, column) -= block.at(i, column) * coef;
+				inverse.at(row, column) -= inverse.at(i, column) * coef;
+			}
+		}
+	}
+
+	return determinant;
+}
+
+CStrassenSchurDeterminant::CStrassenSchurDeterminant(CMatrix&& source_matrix) : result_computed(false), used_fallback(false), cutoff(STRASSEN_DEFAULT_CUTOFF), multiplication_count(0), matrix(std::move(source_matrix))
+{
+}
+
+CStrassenSchurDeterminant::CStrassenSchurDeterminant(const CMatrix& source_matrix) : CStrassenSchurDeterminant(CMatrix(source_matrix))
+{
+}
+
+void CStrassenSchurDeterminant::set_cutoff(matrix_size cutoff)
+{
+	// cutoff of 0 would never reach the base case
+	if (!this->result_computed && cutoff > 0)
+		this->cutoff = cutoff;
+}
+
+matrix_size CStrassenSchurDeterminant::get_cutoff() const
+{
+	return cutoff;
+}
+
+bool CStrassenSchurDeterminant::get_used_fallback() const
+{
+	return used_fallback;
+}
+
+unsigned long long CStrassenSchurDeterminant::get_multiplication_count() const
+{
+	return multiplication_count;
+}
+
+millisecond_time_difference CStrassenSchurDeterminant::get_setup_time() const
+{
+	return setup_time;
+}
+
+millisecond_time_difference CStrassenSchurDeterminant::get_computation_time() const
+{
+	return computation_time;
+}
+
+const matrix_member& CStrassenSchurDeterminant::get_result()
+{
+	if (!result_computed)
+		compute_result();
+
+	return determinant;
+}
+
+CDenseBlock CStrassenSchurDeterminant::multiply(const CDenseBlock& a, const CDenseBlock& b)
+{
+	multiplication_count++;
+	return strassen_multiply(a, b, cutoff);
+}
+
+matrix_member CStrassenSchurDeterminant::compute_inverse(const CDenseBlock& block, CDenseBlock& inverse)
+{
+	const matrix_size size = block.get_row_count();
+
+	if (size <= cutoff)
+		return base_inverse(block, inverse);
+
+	const matrix_size half = size / 2;
+	const matrix_size rest = size - half;
+
+	const CDenseBlock a = block.get_block(0, 0, half, half);
+	const CDenseBlock b = block.get_block(0, half, half, rest);
+	const CDenseBlock c = block.get_block(half, 0, rest, half);
+	const CDenseBlock d = block.get_block(half, half, rest, rest);
+
+	CDenseBlock a_inverse(0, 0);
+	const matrix_member a_determinant = compute_inverse(a, a_inverse);
+
+	const CDenseBlock x = multiply(a_inverse, b);
+	const CDenseBlock y = multiply(c, a_inverse);
+	const CDenseBlock schur = d - multiply(c, x);
+
+	CDenseBlock schur_inverse(0, 0);
+	const matrix_member schur_determinant = compute_inverse(schur, schur_inverse);
+
+	const CDenseBlock z = multiply(schur_inverse, y);
+
+	// [A B; C D]^-1 = [A^-1 + X S^-1 Y, -X S^-1; -S^-1 Y, S^-1] where X = A^-1 B, Y = C A^-1, S = D - C X
+	inverse = CDenseBlock(size, size);
+	inverse.set_block(0, 0, a_inverse + multiply(x, z));
+	inverse.set_block(0, half, CDenseBlock(half, rest) - multiply(x, schur_inverse));
+	inverse.set_block(half, 0, CDenseBlock(rest, half) - z);
+	inverse.set_block(half, half, schur_inverse);
+
+	return a_determinant * schur_determinant;
+}
+
+matrix_member CStrassenSchurDeterminant::compute_determinant(const CDenseBlock& block)
+{
+	const matrix_size size = block.get_row_count();
+
+	if (size <= cutoff)
+		return base_determinant(block);
+
+	const matrix_size half = size / 2;
+	const matrix_size rest = size - half;
+
+	CDenseBlock a_inverse(0, 0);
+	const matrix_member a_determinant = compute_inverse(block.get_block(0, 0, half, half), a_inverse);
+
+	// only the determinant of the schur complement is needed, so its inverse is never formed
+	const CDenseBlock x = multiply(a_inverse, block.get_block(0, half, half, rest));
+	const CDenseBlock schur = block.get_block(half, half, rest, rest) - multiply(block.get_block(half, 0, rest, half), x);
+
+	return a_determinant * compute_determinant(schur);
+}
+
+void CStrassenSchurDeterminant::compute_result()
+{
+	if (result_computed)
+		return;
+
+	if (!is_matrix_square(matrix))
+		throw matrix_exception("determinant of a matrix that is not square");
+
+	time_value setup_start = get_current_time();
+	const matrix_size size = matrix.get_row_count();
+	CDenseBlock block(std::move(matrix)); // rows of matrix are released while copying, only the block is kept
+	time_value computation_start = get_current_time();
+
+	try
+	{
+		determinant = size == 0 ? matrix_member(0) : compute_determinant(block);
+	}
+	catch (singular_block_exception&)
+	{
+		// some leading block is singular even though the whole matrix might not be, plain GEM handles that by swapping rows
+		used_fallback = true;
+		CMatrix fallback_matrix = block.to_matrix();
+		block = CDenseBlock(0, 0);
+		CMatrix gemed_matrix = singlethread_gem_matrix(std::move(fallback_matrix));
+		determinant = multiply_matrix_diagonal(gemed_matrix) * gemed_matrix.get_swap_coefficient();
+	}
+
+	result_computed = true;
+	time_value computation_end = get_current_time();
+
+	setup_time = time_diff(computation_start, setup_start);
+	computation_time = time_diff(computation_end, computation_start);
+}
@@ -0,0 +1,90 @@
+#ifndef _STRASSEN_SCHUR_DETERMINANT_H_
+#define _STRASSEN_SCHUR_DETERMINANT_H_
+
+#include <vector>
+
+#include "Util.h"
+#include "Matrix.h"
+
+#define STRASSEN_DEFAULT_CUTOFF 64
+
+// dense row-major block used by the recursive Schur complement engine
+class CDenseBlock
+{
+private:
+	matrix_size row_count;
+	matrix_size column_count;
+	std::vector<matrix_member> values;
+
+public:
+	matrix_size get_row_count() const;
+	matrix_size get_column_count() const;
+
+	matrix_member& at(matrix_size row, matrix_size column);
+	const matrix_member& at(matrix_size row, matrix_size column) const;
+
+	// copies rows x columns sub-block starting at (first_row, first_column), parts outside of this block are filled with 0
+	CDenseBlock get_block(matrix_size first_row, matrix_size first_column, matrix_size rows, matrix_size columns) const;
+	// copies the whole source block to (first_row, first_column), parts of source outside of this block are ignored
+	void set_block(matrix_size first_row, matrix_size first_column, const CDenseBlock& source);
+
+	CMatrix to_matrix() const;
+
+	CDenseBlock& operator+=(const CDenseBlock& other);
+	CDenseBlock& operator-=(const CDenseBlock& other);
+
+	CDenseBlock(const CMatrix& matrix);
+	// rows of matrix are released as soon as they are copied, so both copies are never in memory at once
+	CDenseBlock(CMatrix&& matrix);
+	CDenseBlock(matrix_size rows, matrix_size columns);
+};
+
+CDenseBlock operator+(const CDenseBlock& block, const CDenseBlock& other);
+CDenseBlock operator-(const CDenseBlock& block, const CDenseBlock& other);
+
+// classic blocked multiplication, used below the cutoff
+CDenseBlock classic_multiply(const CDenseBlock& a, const CDenseBlock& b);
+// Strassen-Winograd multiplication, falls back to classic_multiply when any dimension is not above cutoff
+CDenseBlock strassen_multiply(const CDenseBlock& a, const CDenseBlock& b, matrix_size cutoff);
+
+/*
+ * Computes determinant as det(A) = det(A11) * det(A22 - A21 * A11^-1 * A12) recursively,
+ * both A11^-1 (block inversion) and the Schur complement are computed using strassen_multiply.
+ * If some leading block turns out to be singular the determinant is computed using singlethread GEM instead.
+ */
+class CStrassenSchurDeterminant
+{
+private:
+	bool result_computed;
+	bool used_fallback;
+	matrix_size cutoff;
+
+	unsigned long long multiplication_count;
+
+	millisecond_time_difference setup_time;
+	millisecond_time_difference computation_time;
+
+	CMatrix matrix;
+	matrix_member determinant;
+
+	matrix_member compute_determinant(const CDenseBlock& block);
+	matrix_member compute_inverse(const CDenseBlock& block, CDenseBlock& inverse);
+	CDenseBlock multiply(const CDenseBlock& a, const CDenseBlock& b);
+
+public:
+	matrix_size get_cutoff() const;
+	bool get_used_fallback() const;
+	unsigned long long get_multiplication_count() const;
+
+	millisecond_time_difference get_setup_time() const;
+	millisecond_time_difference get_computation_time() const;
+
+	void set_cutoff(matrix_size cutoff);
+
+	const matrix_member& get_result();
+	void compute_result();
+
+	CStrassenSchurDeterminant(CMatrix&& source_matrix);
+	CStrassenSchurDeterminant(const CMatrix& source_matrix);
+};
+#endif // !_STRASSEN_SCHUR_DETERMINANT_H_
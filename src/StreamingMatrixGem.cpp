@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <thread>
+#include <exception>
+
+#include "StreamingMatrixGem.h"
+#include "MatrixUtils.h"
+#include "Util.h"
+
+CStreamingMatrixGem::CStreamingMatrixGem(std::istream& input, const char line_delimiter)
+	:
+	result_computed(false),
+	num_threads(std::max(std::thread::hardware_concurrency(), 1u)),
+	input(input),
+	line_delimiter(line_delimiter),
+	row_count(0),
+	column_count(0),
+	parsing_time(0),
+	computation_time(0),
+	input_wait_time(0),
+	determinant(0),
+	singular(false),
+	parsed_rows(STREAMING_QUEUE_CAPACITY)
+{
+}
+
+unsigned int CStreamingMatrixGem::get_num_threads() const
+{
+	return num_threads;
+}
+
+matrix_size CStreamingMatrixGem::get_size() const
+{
+	return row_count;
+}
+
+millisecond_time_difference CStreamingMatrixGem::get_parsing_time() const
+{
+	return parsing_time;
+}
+
+millisecond_time_difference CStreamingMatrixGem::get_computation_time() const
+{
+	return computation_time;
+}
+
+millisecond_time_difference CStreamingMatrixGem::get_input_wait_time() const
+{
+	return input_wait_time;
+}
+
+void CStreamingMatrixGem::set_num_threads(unsigned int num_threads)
+{
+	if (!result_computed && num_threads > 0)
+		this->num_threads = num_threads;
+}
+
+const matrix_member& CStreamingMatrixGem::get_result()
+{
+	if (!result_computed)
+		compute_result();
+
+	return determinant;
+}
+
+void CStreamingMatrixGem::work()
+{
+	while (true)
+	{
+		std::vector<matrix_member> values;
+		matrix_size row;
+		{
+			std::lock_guard<std::mutex> input_lock(input_guard);
+			time_value wait_start = get_current_time();
+
+			if (!parsed_rows.pop(values))
+				return;
+
+			input_wait_time += time_diff(get_current_time(), wait_start);
+			row = row_count++;
+			column_count = std::max(column_count, (matrix_size)values.size());
+		}
+
+		// reduce by the rows before this one as they get finished
+		std::vector<const finished_row*> pivot_rows;
+		bool skip = false;
+
+		for (matrix_size pivot_row = 0; pivot_row < row && !skip; pivot_row++)
+		{
+			if (pivot_row == pivot_rows.size())
+			{
+				std::unique_lock<std::mutex> lock(guard);
+				row_finished.wait(lock, [this, pivot_row] { return singular || finished_rows.size() > pivot_row; });
+
+				// once the determinant is known to be 0 the rows are only counted
+				skip = singular;
+
+				for (matrix_size available = pivot_row; available < finished_rows.size(); available++)
+					pivot_rows.push_back(finished_rows[available].get());
+			}
+
+			if (!skip)
+				reduce_row_by_pivot(values, pivot_rows[pivot_row]->values, pivot_rows[pivot_row]->pivot_column);
+		}
+
+		if (skip)
+			continue;
+
+		matrix_size pivot_column = 0;
+
+		for (matrix_size column = 1; column < values.size(); column++)
+			if (abs(values[column]) > abs(values[pivot_column]))
+				pivot_column = column;
+
+		std::unique_ptr<finished_row> finished(new finished_row{ std::move(values), pivot_column });
+
+		std::lock_guard<std::mutex> lock(guard);
+
+		// row is linearly dependent on the previous ones
+		if (finished->values.empty() || finished->values[pivot_column] == 0)
+			singular = true;
+		else if (!singular)
+		{
+			determinant *= finished->values[pivot_column];
+			finished_rows.push_back(std::move(finished));
+		}
+
+		row_finished.notify_all();
+	}
+}
+
+void CStreamingMatrixGem::compute_result()
+{
+	if (result_computed)
+		return;
+
+	time_value start = get_current_time();
+
+	determinant = 1;
+	std::exception_ptr parsing_error;
+
+	std::thread parser([this, &parsing_error]()
+	{
+		time_value parsing_start = get_current_time();
+
+		try
+		{
+			parse_matrix_rows(input, line_delimiter, [this](std::vector<matrix_member>&& values)
+			{
+				parsed_rows.push(std::move(values));
+			});
+		}
+		catch (...)
+		{
+			parsing_error = std::current_exception();
+		}
+
+		// workers finish the remaining rows and stop
+		parsed_rows.close();
+		parsing_time = time_diff(get_current_time(), parsing_start);
+	});
+
+	// calling thread is one of the workers
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < num_threads; i++)
+		workers.push_back(std::thread(&CStreamingMatrixGem::work, this));
+
+	work();
+
+	for (auto& worker : workers)
+		worker.join();
+
+	parser.join();
+
+	if (parsing_error)
+		std::rethrow_exception(parsing_error);
+
+	if (row_count != column_count)
+		throw non_square_matrix_exception(row_count, column_count);
+
+	if (singular || row_count == 0)
+		determinant = 0;
+	else
+	{
+		std::vector<matrix_size> pivot_columns;
+
+		for (const auto& row : finished_rows)
+			pivot_columns.push_back(row->pivot_column);
+
+		determinant *= get_permutation_sign(pivot_columns);
+	}
+
+	finished_rows.clear();
+	result_computed = true;
+	computation_time = time_diff(get_current_time(), start);
+}
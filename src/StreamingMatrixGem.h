@@ -0,0 +1,72 @@
+#ifndef _STREAMING_MATRIX_GEM_H_
+#define _STREAMING_MATRIX_GEM_H_
+
+#include <istream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+#include "Util.h"
+#include "Matrix.h"
+#include "BoundedQueue.h"
+
+#define STREAMING_QUEUE_CAPACITY 64 // parsed rows waiting for elimination
+
+/*
+ * Gauss elimination running while the matrix is still being parsed. A parser thread hands rows over through a bounded queue,
+ * every row is reduced by all finished rows as soon as it arrives and finished right away, so only the reduced rows are kept.
+ * Rows are taken by several workers - a worker waits for the rows before its own one to be finished one by one,
+ * so consecutive rows are reduced in a wavefront. Pivots are chosen by columns (largest element of the reduced row),
+ * which is what allows finishing a row without knowing the rows below it.
+ */
+class CStreamingMatrixGem
+{
+private:
+	struct finished_row
+	{
+		std::vector<matrix_member> values;
+		matrix_size pivot_column;
+	};
+
+	bool result_computed;
+	unsigned int num_threads;
+
+	std::istream& input;
+	const char line_delimiter;
+
+	matrix_size row_count;
+	matrix_size column_count;
+
+	millisecond_time_difference parsing_time;
+	millisecond_time_difference computation_time;
+	millisecond_time_difference input_wait_time; // summed over all workers
+
+	matrix_member determinant;
+	bool singular;
+
+	CBoundedQueue<std::vector<matrix_member>> parsed_rows;
+	std::mutex input_guard; // taking a row and numbering it has to be atomic
+	std::vector<std::unique_ptr<finished_row>> finished_rows;
+	std::mutex guard;
+	std::condition_variable row_finished;
+
+	void work();
+
+public:
+	unsigned int get_num_threads() const;
+	matrix_size get_size() const;
+
+	millisecond_time_difference get_parsing_time() const;
+	// from start of parsing until the last row is finished
+	millisecond_time_difference get_computation_time() const;
+	millisecond_time_difference get_input_wait_time() const;
+
+	void set_num_threads(unsigned int num_threads);
+
+	const matrix_member& get_result();
+	void compute_result();
+
+	CStreamingMatrixGem(std::istream& input, const char line_delimiter);
+};
+#endif // !_STREAMING_MATRIX_GEM_H_
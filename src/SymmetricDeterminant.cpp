@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "SymmetricDeterminant.h"
+#include "MatrixUtils.h"
+
+bool is_matrix_symmetric(const CMatrix& matrix)
+{
+	if (!is_matrix_square(matrix))
+		return false;
+
+	for (matrix_size row = 1; row < matrix.get_row_count(); row++)
+		for (matrix_size column = 0; column < row; column++)
+			if (matrix.get_value(row, column) != matrix.get_value(column, row))
+				return false;
+
+	return true;
+}
+
+CPackedSymmetricMatrix::CPackedSymmetricMatrix(matrix_size size) : size(size), values((size_t)size * (size + 1) / 2, MATRIX_INITIALIZATION_VALUE)
+{
+}
+
+CPackedSymmetricMatrix::CPackedSymmetricMatrix(CMatrix&& matrix) : size(matrix.get_row_count())
+{
+	if (!is_matrix_square(matrix))
+		throw matrix_exception("packed symmetric storage requires a square matrix");
+
+	values.reserve((size_t)size * (size + 1) / 2);
+
+	// packed rows follow each other, so every row is appended and released right away
+	for (matrix_size row = 0; row < size; row++)
+	{
+		const CMatrixRow* source_row = matrix.get_row(row);
+
+		for (matrix_size column = 0; column <= row; column++)
+			values.push_back(source_row->get_column(column));
+
+		matrix.set_row(row, new CMatrixRow(0));
+	}
+}
+
+matrix_size CPackedSymmetricMatrix::get_size() const
+{
+	return size;
+}
+
+size_t CPackedSymmetricMatrix::get_member_count() const
+{
+	return values.size();
+}
+
+matrix_member& CPackedSymmetricMatrix::at(matrix_size row, matrix_size column)
+{
+	if (row < column)
+		std::swap(row, column);
+
+	return values[(size_t)row * (row + 1) / 2 + column];
+}
+
+const matrix_member& CPackedSymmetricMatrix::at(matrix_size row, matrix_size column) const
+{
+	if (row < column)
+		std::swap(row, column);
+
+	return values[(size_t)row * (row + 1) / 2 + column];
+}
+
+void CPackedSymmetricMatrix::swap_symmetric(matrix_size first, matrix_size second, matrix_size first_active)
+{
+	if (first == second)
+		return;
+
+	if (first > second)
+		std::swap(first, second);
+
+	std::swap(at(first, first), at(second, second));
+
+	for (matrix_size i = first_active; i < first; i++)
+		std::swap(at(first, i), at(second, i));
+
+	// (second, first) stays where it is
+	for (matrix_size i = first + 1; i < second; i++)
+		std::swap(at(i, first), at(second, i));
+
+	for (matrix_size i = second + 1; i < size; i++)
+		std::swap(at(i, first), at(i, second));
+}
+
+CSymmetricDeterminant::CSymmetricDeterminant(CMatrix&& source_matrix)
+	:
+	result_computed(false),
+	num_threads(std::max(std::thread::hardware_concurrency(), 1u)),
+	cholesky_steps(0),
+	two_by_two_pivot_count(0),
+	computation_time(0),
+	matrix(std::move(source_matrix)),
+	row_scales(matrix.get_size(), 0),
+	determinant(0),
+	ldlt_determinant(1)
+{
+	for (matrix_size row = 0; row < matrix.get_size(); row++)
+	{
+		for (matrix_size column = 0; column <= row; column++)
+		{
+			const matrix_member value = abs(matrix.at(row, column));
+			row_scales[row] += value;
+
+			if (column != row)
+				row_scales[column] += value;
+		}
+	}
+}
+
+unsigned int CSymmetricDeterminant::get_num_threads() const
+{
+	return num_threads;
+}
+
+bool CSymmetricDeterminant::is_positive_definite()
+{
+	if (!result_computed)
+		compute_result();
+
+	return cholesky_steps == matrix.get_size();
+}
+
+matrix_size CSymmetricDeterminant::get_cholesky_steps() const
+{
+	return cholesky_steps;
+}
+
+matrix_size CSymmetricDeterminant::get_two_by_two_pivot_count() const
+{
+	return two_by_two_pivot_count;
+}
+
+size_t CSymmetricDeterminant::get_member_count() const
+{
+	return matrix.get_member_count();
+}
+
+millisecond_time_difference CSymmetricDeterminant::get_computation_time() const
+{
+	return computation_time;
+}
+
+void CSymmetricDeterminant::set_num_threads(unsigned int num_threads)
+{
+	if (!result_computed && num_threads > 0)
+		this->num_threads = num_threads;
+}
+
+const matrix_member& CSymmetricDeterminant::get_result()
+{
+	if (!result_computed)
+		compute_result();
+
+	return determinant;
+}
+
+void CSymmetricDeterminant::update_columns(matrix_size first, const std::function<void(matrix_size)>& update)
+{
+	const matrix_size size = matrix.get_size();
+
+	if (first >= size)
+		return;
+
+	const unsigned int threads = size - first < SYMMETRIC_PARALLEL_MIN_COLUMNS ? 1 : std::min(num_threads, size - first);
+
+	// column j updates rows j..size-1, taking every threads-th column keeps the work of the threads even
+	auto update_every_nth = [&](unsigned int offset)
+	{
+		for (matrix_size column = first + offset; column < size; column += threads)
+			update(column);
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < threads; i++)
+		workers.push_back(std::thread(update_every_nth, i));
+
+	update_every_nth(0);
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+void CSymmetricDeterminant::swap_symmetric(matrix_size first, matrix_size second, matrix_size first_active)
+{
+	matrix.swap_symmetric(first, second, first_active);
+	std::swap(row_scales[first], row_scales[second]);
+}
+
+matrix_member CSymmetricDeterminant::get_pivot_tolerance(matrix_size column) const
+{
+	// backward error bound of the elimination with a generous factor (rank deficient matrices leave more than n * epsilon behind),
+	// relative to the row the column started as - a bound relative to the whole matrix would zero legitimately small pivots of badly scaled matrices
+	static const matrix_member epsilon = get_arithmetic_epsilon();
+	return SYMMETRIC_PIVOT_TOLERANCE_FACTOR * matrix_member(matrix.get_size()) * epsilon * row_scales[column];
+}
+
+bool CSymmetricDeterminant::cholesky_step(matrix_size step)
+{
+	const matrix_size size = matrix.get_size();
+
+	// rounding leftover of a singular matrix can be positive, it's left to LDL^T which recognizes it as 0
+	if (matrix.at(step, step) <= get_pivot_tolerance(step))
+		return false;
+
+	const matrix_member diagonal = sqrt(matrix.at(step, step));
+	matrix.at(step, step) = diagonal;
+
+	for (matrix_size row = step + 1; row < size; row++)
+		matrix.at(row, step) /= diagonal;
+
+	update_columns(step + 1, [this, step, size](matrix_size column)
+	{
+		const matrix_member coef = matrix.at(column, step);
+
+		if (coef == 0)
+			return;
+
+		for (matrix_size row = column; row < size; row++)
+			matrix.at(row, column) -= matrix.at(row, step) * coef;
+	});
+
+	return true;
+}
+
+matrix_size CSymmetricDeterminant::ldlt_step(matrix_size step)
+{
+	// (1 + sqrt(17)) / 8, bounds the element growth of Bunch-Kaufman pivoting
+	static const matrix_member alpha = (1 + sqrt(matrix_member(17))) / 8;
+
+	const matrix_size size = matrix.get_size();
+
+	// largest off-diagonal member of the column
+	matrix_member lambda = 0;
+	matrix_size largest_row = step;
+
+	for (matrix_size row = step + 1; row < size; row++)
+	{
+		if (abs(matrix.at(row, step)) > lambda)
+		{
+			lambda = abs(matrix.at(row, step));
+			largest_row = row;
+		}
+	}
+
+	const matrix_member diagonal = abs(matrix.at(step, step));
+
+	// pivots chosen below are at least alpha * lambda (2x2 ones have determinant of at least (1 - alpha^2) * lambda^2),
+	// so the column being negligible is the only case the elimination can't continue
+	const matrix_member tolerance = get_pivot_tolerance(step);
+
+	if (lambda <= tolerance && diagonal <= tolerance)
+		return 0;
+
+	bool two_by_two = false;
+
+	if (diagonal < alpha * lambda)
+	{
+		// largest off-diagonal member of the row / column of the candidate pivot
+		matrix_member sigma = 0;
+
+		for (matrix_size i = step; i < size; i++)
+			if (i != largest_row)
+				sigma = std::max(sigma, matrix_member(abs(matrix.at(largest_row, i))));
+
+		if (diagonal * sigma < alpha * lambda * lambda)
+		{
+			if (abs(matrix.at(largest_row, largest_row)) >= alpha * sigma)
+				swap_symmetric(step, largest_row, step);
+			else
+			{
+				swap_symmetric(step + 1, largest_row, step);
+				two_by_two = true;
+			}
+		}
+	}
+
+	if (!two_by_two)
+	{
+		const matrix_member pivot = matrix.at(step, step);
+		ldlt_determinant *= pivot;
+
+		update_columns(step + 1, [this, step, size, &pivot](matrix_size column)
+		{
+			const matrix_member coef = matrix.at(column, step) / pivot;
+
+			if (coef == 0)
+				return;
+
+			for (matrix_size row = column; row < size; row++)
+				matrix.at(row, column) -= matrix.at(row, step) * coef;
+		});
+
+		return 1;
+	}
+
+	// 2x2 pivot D, the trailing matrix is updated by C * D^-1 * C^T where C are columns step and step + 1
+	const matrix_member d00 = matrix.at(step, step);
+	const matrix_member d10 = matrix.at(step + 1, step);
+	const matrix_member d11 = matrix.at(step + 1, step + 1);
+	const matrix_member pivot_determinant = d00 * d11 - d10 * d10;
+
+	ldlt_determinant *= pivot_determinant;
+	two_by_two_pivot_count++;
+
+	update_columns(step + 2, [this, step, size, &d00, &d10, &d11, &pivot_determinant](matrix_size column)
+	{
+		const matrix_member c0 = matrix.at(column, step);
+		const matrix_member c1 = matrix.at(column, step + 1);
+		const matrix_member w0 = (c0 * d11 - c1 * d10) / pivot_determinant;
+		const matrix_member w1 = (c1 * d00 - c0 * d10) / pivot_determinant;
+
+		for (matrix_size row = column; row < size; row++)
+			matrix.at(row, column) -= matrix.at(row, step) * w0 + matrix.at(row, step + 1) * w1;
+	});
+
+	return 2;
+}
+
+void CSymmetricDeterminant::compute_result()
+{
+	if (result_computed)
+		return;
+
+	time_value computation_start = get_current_time();
+
+	const matrix_size size = matrix.get_size();
+	matrix_size step = 0;
+	bool singular = false;
+
+	while (step < size && cholesky_step(step))
+		step++;
+
+	cholesky_steps = step;
+
+	// Schur complement of the factored part is symmetric but not positive definite
+	while (step < size && !singular)
+	{
+		const matrix_size eliminated = ldlt_step(step);
+
+		singular = eliminated == 0;
+		step += eliminated;
+	}
+
+	if (singular)
+		determinant = 0;
+	else
+	{
+		determinant = ldlt_determinant;
+
+		for (matrix_size i = 0; i < cholesky_steps; i++)
+			determinant *= matrix.at(i, i) * matrix.at(i, i);
+	}
+
+	// empty matrix has determinant 0, same as the other implementations
+	if (size == 0)
+		determinant = 0;
+
+	result_computed = true;
+	computation_time = time_diff(get_current_time(), computation_start);
+}
@@ -0,0 +1,87 @@
+#ifndef _SYMMETRIC_DETERMINANT_H_
+#define _SYMMETRIC_DETERMINANT_H_
+
+#include <vector>
+#include <functional>
+
+#include "Util.h"
+#include "Matrix.h"
+
+#define SYMMETRIC_PARALLEL_MIN_COLUMNS 32 // smaller trailing updates are done by the calling thread only
+#define SYMMETRIC_PIVOT_TOLERANCE_FACTOR 64 // pivots below factor * n * epsilon * norm of their original row are rounding leftovers
+
+bool is_matrix_symmetric(const CMatrix& matrix);
+
+// lower triangle of a symmetric matrix stored by rows, n * (n + 1) / 2 members instead of n * n
+class CPackedSymmetricMatrix
+{
+private:
+	matrix_size size;
+	std::vector<matrix_member> values;
+
+public:
+	matrix_size get_size() const;
+	size_t get_member_count() const;
+
+	// row and column can be given in any order, (row, column) and (column, row) is the same member
+	matrix_member& at(matrix_size row, matrix_size column);
+	const matrix_member& at(matrix_size row, matrix_size column) const;
+
+	// symmetric swap of rows and columns first and second, only members with both indices >= first_active are moved
+	void swap_symmetric(matrix_size first, matrix_size second, matrix_size first_active);
+
+	// only the lower triangle of matrix is read, rows of matrix are released as they are packed
+	CPackedSymmetricMatrix(CMatrix&& matrix);
+	CPackedSymmetricMatrix(matrix_size size);
+};
+
+/*
+ * Determinant of a symmetric matrix in packed storage. Cholesky factorization runs (determinant is the product of squared diagonal of L)
+ * until a non-positive pivot shows up, the Schur complement left at that point is factored by LDL^T with Bunch-Kaufman pivoting
+ * (1x1 and 2x2 pivots), which works for any symmetric matrix. Symmetric swaps don't change the determinant.
+ * Only the lower triangle is stored and updated, so both the work and the memory are half of gauss elimination.
+ */
+class CSymmetricDeterminant
+{
+private:
+	bool result_computed;
+	unsigned int num_threads;
+
+	matrix_size cholesky_steps; // columns factored by Cholesky before the fallback (all of them if positive definite)
+	matrix_size two_by_two_pivot_count;
+
+	millisecond_time_difference computation_time;
+
+	CPackedSymmetricMatrix matrix;
+	std::vector<matrix_member> row_scales; // sum of absolute values of each original row, swapped along with the rows
+	matrix_member determinant;
+	matrix_member ldlt_determinant; // product of determinants of the LDL^T pivots
+
+	// calls update(column) for all columns from first on, split between num_threads threads
+	void update_columns(matrix_size first, const std::function<void(matrix_size)>& update);
+	void swap_symmetric(matrix_size first, matrix_size second, matrix_size first_active);
+	// members of the column below this are indistinguishable from 0 after rounding
+	matrix_member get_pivot_tolerance(matrix_size column) const;
+	// returns false if the pivot is not positive (or negligible), matrix is not changed in that case
+	bool cholesky_step(matrix_size step);
+	// returns number of columns eliminated (1 or 2), 0 if the matrix is singular (the whole column is negligible)
+	matrix_size ldlt_step(matrix_size step);
+
+public:
+	unsigned int get_num_threads() const;
+	bool is_positive_definite();
+	matrix_size get_cholesky_steps() const;
+	matrix_size get_two_by_two_pivot_count() const;
+	size_t get_member_count() const;
+
+	millisecond_time_difference get_computation_time() const;
+
+	void set_num_threads(unsigned int num_threads);
+
+	const matrix_member& get_result();
+	void compute_result();
+
+	// source_matrix is released while it is packed
+	CSymmetricDeterminant(CMatrix&& source_matrix);
+};
+#endif // !_SYMMETRIC_DETERMINANT_H_
@@ -0,0 +1,407 @@
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "TiledMatrixLu.h"
+#include "MatrixUtils.h"
+#include "Util.h"
+
+bool tile_task_priority::operator()(const tile_task& a, const tile_task& b) const
+{
+	// true if a should run after b
+	if (a.tile_column != b.tile_column)
+		return a.tile_column > b.tile_column;
+
+	if (a.step != b.step)
+		return a.step > b.step;
+
+	if (a.type != b.type)
+		return a.type > b.type;
+
+	return a.tile_row > b.tile_row;
+}
+
+CTiledMatrixLu::CTiledMatrixLu(CMatrix&& source_matrix)
+	:
+	result_computed(false),
+	num_threads(std::max(std::thread::hardware_concurrency(), 1u)),
+	tile_size(TILED_LU_DEFAULT_TILE_SIZE),
+	tile_count(0),
+	setup_time(0),
+	computation_time(0),
+	wall_time(0),
+	busy_time(0),
+	task_count(0),
+	matrix(std::move(source_matrix)),
+	determinant(0),
+	singular(false),
+	finished(false),
+	factors_permuted(false)
+{
+	if (matrix.get_row_count() != matrix.get_column_count())
+		throw matrix_exception("tiled LU requires a square matrix");
+}
+
+CTiledMatrixLu::CTiledMatrixLu(const CMatrix& source_matrix) : CTiledMatrixLu(CMatrix(source_matrix))
+{
+}
+
+unsigned int CTiledMatrixLu::get_num_threads() const
+{
+	return num_threads;
+}
+
+matrix_size CTiledMatrixLu::get_tile_size() const
+{
+	return tile_size;
+}
+
+unsigned long long CTiledMatrixLu::get_task_count() const
+{
+	return task_count;
+}
+
+millisecond_time_difference CTiledMatrixLu::get_setup_time() const
+{
+	return setup_time;
+}
+
+millisecond_time_difference CTiledMatrixLu::get_computation_time() const
+{
+	return computation_time;
+}
+
+double CTiledMatrixLu::get_utilisation() const
+{
+	if (wall_time <= 0)
+		return 0;
+
+	return std::min((double)busy_time / ((double)wall_time * num_threads), 1.0);
+}
+
+void CTiledMatrixLu::set_num_threads(unsigned int num_threads)
+{
+	if (!result_computed && num_threads > 0)
+		this->num_threads = num_threads;
+}
+
+void CTiledMatrixLu::set_tile_size(matrix_size tile_size)
+{
+	if (!result_computed && tile_size > 0)
+		this->tile_size = tile_size;
+}
+
+bool CTiledMatrixLu::is_singular() const
+{
+	return singular;
+}
+
+const CDenseBlock& CTiledMatrixLu::get_factors()
+{
+	if (!result_computed)
+		compute_result();
+
+	if (!factors_permuted && !singular)
+	{
+		for (matrix_size pivot = tile_size; pivot < matrix.get_row_count(); pivot++)
+		{
+			if (pivots[pivot] == pivot)
+				continue;
+
+			// columns of the panels before the one containing pivot
+			const matrix_size end_column = pivot - pivot % tile_size;
+
+			for (matrix_size column = 0; column < end_column; column++)
+				std::swap(matrix.at(pivot, column), matrix.at(pivots[pivot], column));
+		}
+
+		factors_permuted = true;
+	}
+
+	return matrix;
+}
+
+const std::vector<matrix_size>& CTiledMatrixLu::get_pivots() const
+{
+	return pivots;
+}
+
+const matrix_member& CTiledMatrixLu::get_result()
+{
+	if (!result_computed)
+		compute_result();
+
+	return determinant;
+}
+
+matrix_size CTiledMatrixLu::get_tile_end(matrix_size tile) const
+{
+	return std::min((tile + 1) * tile_size, matrix.get_row_count());
+}
+
+bool CTiledMatrixLu::factor_panel(matrix_size step)
+{
+	using std::abs;
+
+	const matrix_size row_count = matrix.get_row_count();
+	const matrix_size first_column = step * tile_size;
+	const matrix_size end_column = get_tile_end(step);
+
+	for (matrix_size pivot = first_column; pivot < end_column; pivot++)
+	{
+		matrix_size pivot_row = pivot;
+
+		for (matrix_size row = pivot + 1; row < row_count; row++)
+			if (abs(matrix.at(row, pivot)) > abs(matrix.at(pivot_row, pivot)))
+				pivot_row = row;
+
+		if (matrix.at(pivot_row, pivot) == 0)
+			return false;
+
+		pivots[pivot] = pivot_row;
+
+		// only the panel columns are swapped here, swap tasks do the same for the columns to the right
+		if (pivot_row != pivot)
+			for (matrix_size column = first_column; column < end_column; column++)
+				std::swap(matrix.at(pivot, column), matrix.at(pivot_row, column));
+
+		const matrix_member div = matrix.at(pivot, pivot);
+
+		for (matrix_size row = pivot + 1; row < row_count; row++)
+		{
+			matrix_member& coef = matrix.at(row, pivot);
+			coef /= div;
+
+			if (coef == 0)
+				continue;
+
+			for (matrix_size column = pivot + 1; column < end_column; column++)
+				matrix.at(row, column) -= coef * matrix.at(pivot, column);
+		}
+	}
+
+	return true;
+}
+
+void CTiledMatrixLu::swap_rows(matrix_size step, matrix_size tile_column)
+{
+	const matrix_size first_column = tile_column * tile_size;
+	const matrix_size end_column = get_tile_end(tile_column);
+
+	for (matrix_size pivot = step * tile_size; pivot < get_tile_end(step); pivot++)
+		if (pivots[pivot] != pivot)
+			for (matrix_size column = first_column; column < end_column; column++)
+				std::swap(matrix.at(pivot, column), matrix.at(pivots[pivot], column));
+}
+
+void CTiledMatrixLu::solve_tile(matrix_size step, matrix_size tile_column)
+{
+	const matrix_size first_column = tile_column * tile_size;
+	const matrix_size end_column = get_tile_end(tile_column);
+	const matrix_size end_pivot = get_tile_end(step);
+
+	for (matrix_size pivot = step * tile_size; pivot < end_pivot; pivot++)
+	{
+		for (matrix_size row = pivot + 1; row < end_pivot; row++)
+		{
+			const matrix_member coef = matrix.at(row, pivot);
+
+			if (coef == 0)
+				continue;
+
+			for (matrix_size column = first_column; column < end_column; column++)
+				matrix.at(row, column) -= coef * matrix.at(pivot, column);
+		}
+	}
+}
+
+void CTiledMatrixLu::update_tile(matrix_size step, matrix_size tile_row, matrix_size tile_column)
+{
+	const matrix_size first_column = tile_column * tile_size;
+	const matrix_size end_column = get_tile_end(tile_column);
+	const matrix_size end_pivot = get_tile_end(step);
+
+	for (matrix_size row = tile_row * tile_size; row < get_tile_end(tile_row); row++)
+	{
+		for (matrix_size pivot = step * tile_size; pivot < end_pivot; pivot++)
+		{
+			const matrix_member coef = matrix.at(row, pivot);
+
+			if (coef == 0)
+				continue;
+
+			for (matrix_size column = first_column; column < end_column; column++)
+				matrix.at(row, column) -= coef * matrix.at(pivot, column);
+		}
+	}
+}
+
+bool CTiledMatrixLu::run_task(const tile_task& task)
+{
+	switch (task.type)
+	{
+	case tile_task_type::panel:
+		return factor_panel(task.step);
+
+	case tile_task_type::swap:
+		swap_rows(task.step, task.tile_column);
+		break;
+
+	case tile_task_type::solve:
+		solve_tile(task.step, task.tile_column);
+		break;
+
+	case tile_task_type::update:
+		update_tile(task.step, task.tile_row, task.tile_column);
+		break;
+	}
+
+	return true;
+}
+
+void CTiledMatrixLu::release_swap(matrix_size step, matrix_size tile_column)
+{
+	if (--swap_dependencies[step * tile_count + tile_column] == 0)
+		ready_tasks.push({ tile_task_type::swap, step, 0, tile_column });
+}
+
+void CTiledMatrixLu::finish_task(const tile_task& task)
+{
+	switch (task.type)
+	{
+	case tile_task_type::panel:
+		// every other task is an ancestor of the last panel
+		if (task.step == tile_count - 1)
+		{
+			finished = true;
+			break;
+		}
+
+		for (matrix_size tile_column = task.step + 1; tile_column < tile_count; tile_column++)
+			release_swap(task.step, tile_column);
+		break;
+
+	case tile_task_type::swap:
+		ready_tasks.push({ tile_task_type::solve, task.step, 0, task.tile_column });
+		break;
+
+	case tile_task_type::solve:
+		for (matrix_size tile_row = task.step + 1; tile_row < tile_count; tile_row++)
+			ready_tasks.push({ tile_task_type::update, task.step, tile_row, task.tile_column });
+		break;
+
+	case tile_task_type::update:
+		if (task.tile_column == task.step + 1)
+		{
+			if (--panel_dependencies[task.step + 1] == 0)
+				ready_tasks.push({ tile_task_type::panel, task.step + 1, 0, task.step + 1 });
+		}
+		else
+			release_swap(task.step + 1, task.tile_column);
+		break;
+	}
+
+	work_sync.notify_all();
+}
+
+void CTiledMatrixLu::work()
+{
+	std::unique_lock<std::mutex> lock(guard);
+
+	while (true)
+	{
+		work_sync.wait(lock, [this] { return finished || !ready_tasks.empty(); });
+
+		if (finished)
+			return;
+
+		const tile_task task = ready_tasks.top();
+		ready_tasks.pop();
+		lock.unlock();
+
+		time_value task_start = get_current_time();
+		const bool success = run_task(task);
+		const microsecond_time_difference task_time = time_diff_us(get_current_time(), task_start);
+
+		lock.lock();
+		busy_time += task_time;
+		task_count++;
+
+		if (!success)
+		{
+			// zero column, no other task matters anymore
+			singular = true;
+			finished = true;
+			work_sync.notify_all();
+			return;
+		}
+
+		finish_task(task);
+	}
+}
+
+void CTiledMatrixLu::compute_result()
+{
+	if (result_computed)
+		return;
+
+	time_value setup_start = get_current_time();
+
+	const matrix_size size = matrix.get_row_count();
+	tile_count = (size + tile_size - 1) / tile_size;
+	pivots.assign(size, 0);
+
+	// panel k waits for the updates of tile column k from step k-1, swap (k, j) for panel k and the updates of tile column j
+	panel_dependencies.assign(tile_count, 0);
+	swap_dependencies.assign((size_t)tile_count * tile_count, 0);
+
+	for (matrix_size step = 1; step < tile_count; step++)
+		panel_dependencies[step] = tile_count - step;
+
+	for (matrix_size step = 0; step < tile_count; step++)
+		for (matrix_size tile_column = step + 1; tile_column < tile_count; tile_column++)
+			swap_dependencies[step * tile_count + tile_column] = 1 + (step > 0 ? tile_count - step : 0);
+
+	finished = tile_count == 0;
+
+	if (!finished)
+		ready_tasks.push({ tile_task_type::panel, 0, 0, 0 });
+
+	time_value computation_start = get_current_time();
+
+	// calling thread is one of the workers
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < num_threads; i++)
+		workers.push_back(std::thread(&CTiledMatrixLu::work, this));
+
+	work();
+
+	for (auto& worker : workers)
+		worker.join();
+
+	time_value computation_end = get_current_time();
+
+	if (singular)
+		determinant = 0;
+	else
+	{
+		determinant = 1;
+
+		for (matrix_size i = 0; i < size; i++)
+		{
+			determinant *= matrix.at(i, i);
+
+			if (pivots[i] != i)
+				determinant = -determinant;
+		}
+	}
+
+	while (!ready_tasks.empty())
+		ready_tasks.pop();
+
+	result_computed = true;
+
+	setup_time = time_diff(computation_start, setup_start);
+	computation_time = time_diff(computation_end, computation_start);
+	wall_time = time_diff_us(computation_end, computation_start);
+}
@@ -0,0 +1,112 @@
+#ifndef _TILED_MATRIX_LU_H_
+#define _TILED_MATRIX_LU_H_
+
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+
+#include "Util.h"
+#include "Matrix.h"
+#include "StrassenSchurDeterminant.h"
+
+#define TILED_LU_DEFAULT_TILE_SIZE 32
+
+enum class tile_task_type
+{
+	panel,   // factors tile column k with partial pivoting
+	swap,    // applies row swaps of panel k to tile column j
+	solve,   // triangular solve of tile (k, j) with the unit lower triangle of tile (k, k)
+	update   // trailing update of tile (i, j) with tiles (i, k) and (k, j)
+};
+
+struct tile_task
+{
+	tile_task_type type;
+	matrix_size step; // k
+	matrix_size tile_row; // i, only used by update
+	matrix_size tile_column; // j
+};
+
+// tasks closer to the next panel go first - this is what makes panel k+1 start while the rest of step k is still running
+struct tile_task_priority
+{
+	bool operator()(const tile_task& a, const tile_task& b) const;
+};
+
+/*
+ * Right-looking LU factorization split into tile tasks. Tasks become ready when all tasks they depend on are finished
+ * (dependency counters, no barrier between pivot steps) and are run by a pool of workers in priority order,
+ * so the panel factorization of column k+1 overlaps with the trailing update of step k.
+ * Partial pivoting searches the whole tile column, so panel tasks span all tile rows below the diagonal.
+ */
+class CTiledMatrixLu
+{
+private:
+	bool result_computed;
+	unsigned int num_threads;
+	matrix_size tile_size;
+	matrix_size tile_count;
+
+	millisecond_time_difference setup_time;
+	millisecond_time_difference computation_time;
+	microsecond_time_difference wall_time;
+	microsecond_time_difference busy_time; // summed over all workers
+	unsigned long long task_count;
+
+	CDenseBlock matrix;
+	std::vector<matrix_size> pivots; // row swapped with row i at step of column i
+	matrix_member determinant;
+
+	bool singular;
+	bool finished;
+	bool factors_permuted;
+	std::vector<matrix_size> panel_dependencies;
+	std::vector<matrix_size> swap_dependencies; // k * tile_count + j
+	std::priority_queue<tile_task, std::vector<tile_task>, tile_task_priority> ready_tasks;
+	std::mutex guard;
+	std::condition_variable work_sync;
+
+	matrix_size get_tile_end(matrix_size tile) const;
+
+	bool factor_panel(matrix_size step);
+	void swap_rows(matrix_size step, matrix_size tile_column);
+	void solve_tile(matrix_size step, matrix_size tile_column);
+	void update_tile(matrix_size step, matrix_size tile_row, matrix_size tile_column);
+
+	// returns false if the panel turned out to be singular
+	bool run_task(const tile_task& task);
+	// called with guard locked, releases tasks that depend on the finished one
+	void finish_task(const tile_task& task);
+	void release_swap(matrix_size step, matrix_size tile_column);
+	void work();
+
+public:
+	unsigned int get_num_threads() const;
+	matrix_size get_tile_size() const;
+	unsigned long long get_task_count() const;
+
+	millisecond_time_difference get_setup_time() const;
+	millisecond_time_difference get_computation_time() const;
+	// fraction of worker time spent running tasks
+	double get_utilisation() const;
+
+	void set_num_threads(unsigned int num_threads);
+	void set_tile_size(matrix_size tile_size);
+
+	// factorization is incomplete when a zero column was found
+	bool is_singular() const;
+	// unit lower triangular L below the diagonal and U above it, so that P * A = L * U
+	// (row swaps of later steps are applied to the L part on the first call, the tasks skip them)
+	const CDenseBlock& get_factors();
+	// P as a sequence of swaps - row i was swapped with row pivots[i] at step of column i
+	const std::vector<matrix_size>& get_pivots() const;
+
+	const matrix_member& get_result();
+	void compute_result();
+
+	// rows of source_matrix are released while they are copied into the tiles
+	CTiledMatrixLu(CMatrix&& source_matrix);
+	CTiledMatrixLu(const CMatrix& source_matrix);
+};
+#endif // !_TILED_MATRIX_LU_H_
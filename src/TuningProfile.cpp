@@ -0,0 +1,236 @@
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+#include "TuningProfile.h"
+#include "MatrixUtils.h"
+#include "MultithreadedMatrixGem.h"
+#include "StrassenSchurDeterminant.h"
+#include "TiledMatrixLu.h"
+
+const char* get_tuned_engine_name(tuned_engine engine)
+{
+	switch (engine)
+	{
+	case tuned_engine::singlethread: return "singlethread";
+	case tuned_engine::multithreaded: return "multithreaded";
+	case tuned_engine::tiled: return "tiled";
+	case tuned_engine::strassen_schur: return "strassen";
+	}
+
+	return "unknown";
+}
+
+static tuned_engine parse_tuned_engine(const std::string& name)
+{
+	for (tuned_engine engine : { tuned_engine::singlethread, tuned_engine::multithreaded, tuned_engine::tiled, tuned_engine::strassen_schur })
+		if (name == get_tuned_engine_name(engine))
+			return engine;
+
+	throw matrix_exception("unknown engine \"" + name + "\" in tuning profile");
+}
+
+bool CTuningProfile::is_empty() const
+{
+	return entries.empty();
+}
+
+const std::vector<tuning_entry>& CTuningProfile::get_entries() const
+{
+	return entries;
+}
+
+const tuning_entry* CTuningProfile::find(matrix_size size) const
+{
+	const tuning_entry* nearest = nullptr;
+	double nearest_distance = 0;
+
+	for (const tuning_entry& entry : entries)
+	{
+		const double distance = std::abs(std::log((double)std::max(size, 1u) / entry.size));
+
+		if (!nearest || distance < nearest_distance)
+		{
+			nearest = &entry;
+			nearest_distance = distance;
+		}
+	}
+
+	return nearest;
+}
+
+void CTuningProfile::add(const tuning_entry& entry)
+{
+	auto position = std::find_if(entries.begin(), entries.end(), [&entry](const tuning_entry& other) { return other.size >= entry.size; });
+
+	if (position != entries.end() && position->size == entry.size)
+		*position = entry;
+	else
+		entries.insert(position, entry);
+}
+
+void CTuningProfile::save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open())
+		throw std::runtime_error("cannot write tuning profile \"" + path + "\"");
+
+	file << TUNING_PROFILE_HEADER << std::endl;
+	file << "# size engine threads block_size time_us" << std::endl;
+
+	for (const tuning_entry& entry : entries)
+		file << entry.size << " " << get_tuned_engine_name(entry.engine) << " " << entry.threads << " " << entry.block_size << " " << entry.time << std::endl;
+
+	if (!file)
+		throw std::runtime_error("cannot write tuning profile \"" + path + "\"");
+}
+
+CTuningProfile CTuningProfile::load(const std::string& path)
+{
+	std::ifstream file(path);
+
+	if (!file.is_open())
+		throw std::runtime_error("cannot open tuning profile \"" + path + "\"");
+
+	CTuningProfile profile;
+	std::string line;
+
+	if (!std::getline(file, line) || line != TUNING_PROFILE_HEADER)
+		throw matrix_exception("\"" + path + "\" is not a tuning profile");
+
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::stringstream stream(line);
+		tuning_entry entry;
+		std::string engine;
+
+		if (!(stream >> entry.size >> engine >> entry.threads >> entry.block_size >> entry.time) || entry.size == 0 || entry.threads == 0)
+			throw matrix_exception("invalid line \"" + line + "\" in tuning profile \"" + path + "\"");
+
+		entry.engine = parse_tuned_engine(engine);
+		profile.add(entry);
+	}
+
+	return profile;
+}
+
+// runs the configuration on matrix repeatedly until it takes long enough to be measured, returns time of one run
+static microsecond_time_difference measure(const CMatrix& matrix, tuned_engine engine, unsigned int threads, matrix_size block_size)
+{
+	microsecond_time_difference total_time = 0;
+	unsigned int repetitions = 0;
+
+	while (repetitions < TUNING_MAX_REPETITIONS && (repetitions == 0 || total_time < TUNING_MIN_MEASURE_TIME_US))
+	{
+		CMatrix copy(matrix);
+		time_value start = get_current_time();
+
+		switch (engine)
+		{
+		case tuned_engine::singlethread:
+			singlethread_gem_matrix(std::move(copy));
+			break;
+
+		case tuned_engine::multithreaded:
+		{
+			CMultithreadedMatrixGem solver(std::move(copy));
+			solver.set_num_threads(threads);
+			solver.compute_result();
+			break;
+		}
+
+		case tuned_engine::tiled:
+		{
+			CTiledMatrixLu solver(std::move(copy));
+			solver.set_num_threads(threads);
+			solver.set_tile_size(block_size);
+			solver.compute_result();
+			break;
+		}
+
+		case tuned_engine::strassen_schur:
+		{
+			CStrassenSchurDeterminant solver(std::move(copy));
+			solver.set_cutoff(block_size);
+			solver.compute_result();
+			break;
+		}
+		}
+
+		total_time += time_diff_us(get_current_time(), start);
+		repetitions++;
+	}
+
+	return total_time / repetitions;
+}
+
+CTuningProfile CTuningProfile::calibrate(const std::vector<matrix_size>& sizes, unsigned int max_threads, std::ostream* log)
+{
+	CTuningProfile profile;
+	std::mt19937 random(0);
+	std::uniform_int_distribution<int> distribution(-9, 9);
+
+	std::vector<unsigned int> thread_counts;
+	for (unsigned int threads = 2; threads < max_threads; threads *= 2)
+		thread_counts.push_back(threads);
+
+	if (max_threads > 1)
+		thread_counts.push_back(max_threads);
+
+	for (matrix_size size : sizes)
+	{
+		CMatrix matrix(size, size);
+
+		for (matrix_size row = 0; row < size; row++)
+			for (matrix_size column = 0; column < size; column++)
+				matrix.set_value(row, column, distribution(random));
+
+		std::vector<tuning_entry> candidates;
+		candidates.push_back({ size, tuned_engine::singlethread, 1, 0, 0 });
+
+		for (unsigned int threads : thread_counts)
+			if (threads <= size)
+				candidates.push_back({ size, tuned_engine::multithreaded, threads, 0, 0 });
+
+		for (matrix_size tile_size : { 16u, 32u, 64u })
+		{
+			if (tile_size >= size)
+				continue;
+
+			candidates.push_back({ size, tuned_engine::tiled, 1, tile_size, 0 });
+
+			for (unsigned int threads : thread_counts)
+				candidates.push_back({ size, tuned_engine::tiled, threads, tile_size, 0 });
+		}
+
+		for (matrix_size cutoff : { 32u, 64u })
+			if (cutoff < size)
+				candidates.push_back({ size, tuned_engine::strassen_schur, 1, cutoff, 0 });
+
+		const tuning_entry* best = nullptr;
+
+		for (tuning_entry& candidate : candidates)
+		{
+			candidate.time = measure(matrix, candidate.engine, candidate.threads, candidate.block_size);
+
+			if (log)
+				*log << "size " << size << ": " << get_tuned_engine_name(candidate.engine) << ", " << candidate.threads << " threads, block size " << candidate.block_size << ": " << candidate.time << "us" << std::endl;
+
+			if (!best || candidate.time < best->time)
+				best = &candidate;
+		}
+
+		if (log)
+			*log << "size " << size << ": using " << get_tuned_engine_name(best->engine) << ", " << best->threads << " threads, block size " << best->block_size << std::endl;
+
+		profile.add(*best);
+	}
+
+	return profile;
+}
@@ -0,0 +1,57 @@
+#ifndef _TUNING_PROFILE_H_
+#define _TUNING_PROFILE_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "Util.h"
+#include "Matrix.h"
+
+#define TUNING_PROFILE_HEADER "# matrix determinant tuning profile"
+#define TUNING_MIN_MEASURE_TIME_US 50000 // small sizes are repeated until the measurement takes at least this long
+#define TUNING_MAX_REPETITIONS 20
+
+enum class tuned_engine
+{
+	singlethread,
+	multithreaded,
+	tiled,
+	strassen_schur
+};
+
+const char* get_tuned_engine_name(tuned_engine engine);
+
+// fastest configuration measured for matrices of the given size
+struct tuning_entry
+{
+	matrix_size size;
+	tuned_engine engine;
+	unsigned int threads;
+	matrix_size block_size; // 0 where the engine doesn't use one
+	microsecond_time_difference time;
+};
+
+/*
+ * Engine, thread count and block size to use per matrix size, measured on the host by calibrate.
+ * Stored as a text file with one entry per line, sizes between the calibrated ones use the nearest one (by ratio).
+ */
+class CTuningProfile
+{
+private:
+	std::vector<tuning_entry> entries; // sorted by size
+
+public:
+	bool is_empty() const;
+	const std::vector<tuning_entry>& get_entries() const;
+	// returns nullptr for an empty profile
+	const tuning_entry* find(matrix_size size) const;
+
+	void add(const tuning_entry& entry);
+	void save(const std::string& path) const;
+
+	static CTuningProfile load(const std::string& path);
+	// measures all engines over sizes with up to max_threads threads on random matrices, progress is written to log (if not null)
+	static CTuningProfile calibrate(const std::vector<matrix_size>& sizes, unsigned int max_threads, std::ostream* log);
+};
+#endif // !_TUNING_PROFILE_H_
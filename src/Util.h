@@ -5,6 +5,7 @@
 
 typedef std::chrono::high_resolution_clock::time_point time_value;
 typedef long long millisecond_time_difference;
+typedef long long microsecond_time_difference;
 
 inline time_value get_current_time()
 {
@@ -15,4 +16,9 @@ inline millisecond_time_difference time_diff(time_value time1, time_value time2)
 {
 	return (millisecond_time_difference) std::chrono::duration_cast<std::chrono::milliseconds>(time1 - time2).count();
 }
+
+inline microsecond_time_difference time_diff_us(time_value time1, time_value time2)
+{
+	return (microsecond_time_difference) std::chrono::duration_cast<std::chrono::microseconds>(time1 - time2).count();
+}
 #endif // !_UTIL_H_
\ No newline at end of file
@@ -6,12 +6,45 @@
 #include "Matrix.h"
 #include "MatrixUtils.h"
 #include "MultithreadedMatrixGem.h"
+#include "StrassenSchurDeterminant.h"
+#include "DistributedMatrixGem.h"
+#include "OutOfCoreMatrixGem.h"
+#include "DeterminantServer.h"
+#include "GemCheckpoint.h"
+#include "FixedSizeDeterminant.h"
+#include "TiledMatrixLu.h"
+#include "ResultVerifier.h"
+#include "StreamingMatrixGem.h"
+#include "TuningProfile.h"
+#include "CompressedInput.h"
+#include "SymmetricDeterminant.h"
+#include "ResultCache.h"
 
 #define PARSING_LINE_DELIMITER '/'
 
 bool use_singlethread_impl = false;
+bool use_strassen_schur_impl = false;
+bool use_tiled_impl = false;
+bool use_streaming_impl = false;
+bool detect_symmetry = true;
 bool print_perf_info = false;
 int num_threads = 0;
+int block_size = 0;
+std::vector<std::string> distributed_workers;
+size_t memory_limit = 0;
+long long timeout_ms = 0;
+std::string checkpoint_path;
+long long checkpoint_interval_s = 60;
+bool resume_from_checkpoint = false;
+bool verify_result = false;
+bool engine_selected = false; // engine was chosen explicitly, tuning profile doesn't override it
+CTuningProfile tuning_profile;
+std::string cache_directory;
+unsigned long long cache_disk_limit = RESULT_CACHE_DEFAULT_DISK_LIMIT;
+CResultCache result_cache;
+
+std::unique_ptr<CResultVerifier> verifier; // set when the result is being verified
+CEliminationLog elimination_log;
 
 millisecond_time_difference parsing_time = 0;
 
@@ -40,12 +73,30 @@ void print_help()
 
 		"Usage: " << " MatrixDeterminant [OPTIONS] INPUT" << std::endl << std::endl <<
 
-		"Expected INPUT is a file containing the matrix to be processed, unless the -m option is used." << std::endl << std::endl <<
+		"Expected INPUT is a file containing the matrix to be processed, unless the -m option is used. Files compressed by gzip, xz or zstd are decompressed on the fly (if supported by the build)." << std::endl << std::endl <<
 
 		"Available OPTIONS: " << "-s         Singlethread implementation will be used for computing the result." << std::endl <<
 		"                   " << "-t NUMBER  NUMBER of threads will be used for computing the result. This option is ignored if used with the -s option." << std::endl <<
+		"                   " << "-w         Recursive Schur complement implementation using Strassen-Winograd multiplication will be used for computing the result." << std::endl <<
+		"                   " << "-b NUMBER  Block size - matrices not larger than NUMBER are handled by the classic kernels in the -w implementation, rows are dealt to workers in blocks of NUMBER rows in the -d implementation, tiles are NUMBER x NUMBER in the --tiled implementation." << std::endl <<
+		"                   " << "-d LIST    Distributed implementation will be used for computing the result. LIST is a comma separated list of worker addresses (unix:PATH or HOST:PORT)." << std::endl <<
+		"                   " << "-l ADDRESS Runs as a distributed worker listening on ADDRESS (unix:PATH or HOST:PORT). No input is required." << std::endl <<
 		"                   " << "-p         Prints performance statistics." << std::endl <<
 		"                   " << "-m         INPUT will be processed directly (as a matrix)." << std::endl <<
+		"                   " << "--tiled    Tiled LU implementation scheduling tile tasks by their dependencies will be used for computing the result. -t sets the number of threads." << std::endl <<
+		"                   " << "--no-symmetric  Symmetric matrices are not detected. Otherwise they are computed by Cholesky factorization (LDL^T with symmetric pivoting if not positive definite) in packed storage, unless an implementation is chosen explicitly or --verify, --timeout or --checkpoint is given." << std::endl <<
+		"                   " << "--stream   Streaming implementation will be used - rows are eliminated on -t threads while the rest of INPUT is still being parsed." << std::endl <<
+		"                   " << "--mem-limit SIZE  Out-of-core implementation will be used - the matrix is kept in temporary files (in $TMPDIR or /tmp) and processed in panels fitting into SIZE bytes (K, M and G suffixes are accepted)." << std::endl <<
+		"                   " << "--timeout MS  Multithreaded computation is cancelled if it doesn't finish in MS milliseconds. Cannot be combined with the other implementations." << std::endl <<
+		"                   " << "--checkpoint PATH  Multithreaded computation periodically saves its state to PATH, the file is removed once the computation finishes. Cannot be combined with the other implementations." << std::endl <<
+		"                   " << "--checkpoint-interval SECONDS  Minimal time between checkpoints (60 seconds by default)." << std::endl <<
+		"                   " << "--resume   Continues from the checkpoint given by --checkpoint if it exists, INPUT is not required (and not parsed) in that case." << std::endl <<
+		"                   " << "--verify   The result is checked - modulo random primes for integer matrices with a small determinant, otherwise by random probes of the elimination residual (-s, multithreaded and --tiled implementations only). A failed check is an error." << std::endl <<
+		"                   " << "--calibrate PROFILE  Measures the implementations, thread counts and block sizes on random matrices of several sizes and saves the fastest ones to PROFILE. -t limits the number of threads tried. No input is required." << std::endl <<
+		"                   " << "--profile PROFILE  Implementation, number of threads and block size are chosen by matrix size from PROFILE created by --calibrate. Options given explicitly take precedence." << std::endl <<
+		"                   " << "--cache-dir DIR  Computed determinants are also stored in DIR (which has to exist) and reused by later runs. Results are always cached in memory, which helps --serve. Has to precede --serve." << std::endl <<
+		"                   " << "--cache-size SIZE  Limit of the size of the entries in --cache-dir (64M by default, K, M and G suffixes are accepted), least recently used ones are removed." << std::endl <<
+		"                   " << "--serve ADDRESS  Runs as a determinant service listening on ADDRESS (unix:PATH or HOST:PORT). Each line received is one matrix, \"stats\" line returns queue depth, latency percentiles and result cache hits. -t sets threads used for large matrices. No input is required." << std::endl <<
 		"                   " << "-h, -help  Prints this message. No input is required and any provided input will be ignored." << std::endl <<
 		"                   " << "-f         Prints information about expected matrix format. No input is required and any provided input will be ignored." << std::endl <<
 		"";
@@ -53,14 +104,8 @@ void print_help()
 
 CMatrix parse_matrix_from_file(const std::string& filename)
 {
-	std::ifstream file(filename);
-
-	if (!file.is_open())
-		throw std::runtime_error("cannot open file \"" + filename + "\"");
-
-	CMatrix matrix = parse_matrix(file, PARSING_LINE_DELIMITER);
-	file.close();
-	return matrix;
+	CInputFile file(filename);
+	return parse_matrix(file.get_stream(), PARSING_LINE_DELIMITER);
 }
 
 CMatrix parse_matrix_from_string(const std::string& str)
@@ -69,12 +114,57 @@ CMatrix parse_matrix_from_string(const std::string& str)
 	return parse_matrix(stream, PARSING_LINE_DELIMITER);
 }
 
+CMatrix run_multithreaded_gem(CMultithreadedMatrixGem& solver)
+{
+	if (num_threads > 0)
+		solver.set_num_threads(num_threads);
+
+	if (!checkpoint_path.empty())
+		solver.set_checkpoint(checkpoint_path, checkpoint_interval_s * 1000);
+
+	if (timeout_ms > 0)
+	{
+		std::shared_ptr<CCancellationToken> token = std::make_shared<CCancellationToken>();
+		std::future<void> result = solver.compute_result_async(token);
+
+		if (result.wait_for(std::chrono::milliseconds(timeout_ms)) == std::future_status::timeout)
+			token->cancel();
+
+		result.get(); // rethrows cancellation_exception
+	}
+	else
+		solver.compute_result();
+
+	if (print_perf_info)
+	{
+		std::cout << "Parsing time: " << parsing_time << "ms" << std::endl;
+		std::cout << std::endl;
+		std::cout << "Multithreaded gauss elimination performance statistics:" << std::endl;
+		std::cout << "Setup time: " << solver.get_setup_time() << "ms" << std::endl;
+		std::cout << "Computation time: " << solver.get_computation_time() << "ms" << std::endl;
+		std::cout << "Time spent synchronizing: " << solver.get_sync_wait_time() << "ms" << std::endl;
+		std::cout << "Cleanup time: " << solver.get_cleanup_time() << "ms" << std::endl;
+		std::cout << "TOTAL GEM TIME: " << solver.get_setup_time() + solver.get_computation_time() + solver.get_sync_wait_time() + solver.get_cleanup_time() << "ms" << std::endl;
+		std::cout << "=== TOTAL TIME: " << solver.get_setup_time() + solver.get_computation_time() + solver.get_sync_wait_time() + solver.get_cleanup_time() + parsing_time << "ms ===" << std::endl;
+		std::cout << "Threads used: " << solver.get_num_threads() << std::endl;
+
+		if (!checkpoint_path.empty())
+			std::cout << "Checkpoints taken: " << solver.get_checkpoint_count() << std::endl;
+	}
+
+	// finished computation doesn't need its checkpoint anymore
+	if (!checkpoint_path.empty())
+		std::remove(checkpoint_path.c_str());
+
+	return solver.get_result();
+}
+
 CMatrix get_gemed_matrix(CMatrix&& source_matrix)
 {
 	if (use_singlethread_impl)
 	{
 		time_value st_start = get_current_time();
-		CMatrix gemed_matrix = singlethread_gem_matrix(std::move(source_matrix));
+		CMatrix gemed_matrix = singlethread_gem_matrix(std::move(source_matrix), verifier ? &elimination_log : nullptr);
 		time_value st_end = get_current_time();
 
 		if (print_perf_info)
@@ -91,26 +181,10 @@ CMatrix get_gemed_matrix(CMatrix&& source_matrix)
 	{
 		CMultithreadedMatrixGem solver(std::move(source_matrix));
 
-		if (num_threads > 0)
-			solver.set_num_threads(num_threads);
-
-		solver.compute_result();
+		if (verifier)
+			solver.set_elimination_log(&elimination_log);
 
-		if (print_perf_info)
-		{
-			std::cout << "Parsing time: " << parsing_time << "ms" << std::endl;
-			std::cout << std::endl;
-			std::cout << "Multithreaded gauss elimination performance statistics:" << std::endl;
-			std::cout << "Setup time: " << solver.get_setup_time() << "ms" << std::endl;
-			std::cout << "Computation time: " << solver.get_computation_time() << "ms" << std::endl;
-			std::cout << "Time spent synchronizing: " << solver.get_sync_wait_time() << "ms" << std::endl;
-			std::cout << "Cleanup time: " << solver.get_cleanup_time() << "ms" << std::endl;
-			std::cout << "TOTAL GEM TIME: " << solver.get_setup_time() + solver.get_computation_time() + solver.get_sync_wait_time() + solver.get_cleanup_time() << "ms" << std::endl;
-			std::cout << "=== TOTAL TIME: " << solver.get_setup_time() + solver.get_computation_time() + solver.get_sync_wait_time() + solver.get_cleanup_time() + parsing_time << "ms ===" << std::endl;
-			std::cout << "Threads used: " << solver.get_num_threads() << std::endl;
-		}
-
-		return solver.get_result();
+		return run_multithreaded_gem(solver);
 	}
 }
 
@@ -119,15 +193,276 @@ CMatrix get_gemed_matrix(const CMatrix& source_matrix)
 	return get_gemed_matrix(CMatrix(source_matrix));
 }
 
+matrix_member get_strassen_schur_determinant(CMatrix&& source_matrix)
+{
+	CStrassenSchurDeterminant solver(std::move(source_matrix));
+
+	if (block_size > 0)
+		solver.set_cutoff(block_size);
+
+	solver.compute_result();
+
+	if (print_perf_info)
+	{
+		std::cout << "Parsing time: " << parsing_time << "ms" << std::endl;
+		std::cout << std::endl;
+		std::cout << "Strassen-Winograd Schur complement performance statistics:" << std::endl;
+		std::cout << "Setup time: " << solver.get_setup_time() << "ms" << std::endl;
+		std::cout << "Computation time: " << solver.get_computation_time() << "ms" << std::endl;
+		std::cout << "=== TOTAL TIME: " << solver.get_setup_time() + solver.get_computation_time() + parsing_time << "ms ===" << std::endl;
+		std::cout << "Cutoff: " << solver.get_cutoff() << std::endl;
+		std::cout << "Block multiplications: " << solver.get_multiplication_count() << std::endl;
+
+		if (solver.get_used_fallback())
+			std::cout << "Singular leading block found, singlethread GEM was used instead" << std::endl;
+	}
+
+	return solver.get_result();
+}
+
+matrix_member get_tiled_determinant(CMatrix&& source_matrix)
+{
+	time_value setup_start = get_current_time();
+	CTiledMatrixLu solver(std::move(source_matrix));
+	millisecond_time_difference copy_time = time_diff(get_current_time(), setup_start);
+
+	if (num_threads > 0)
+		solver.set_num_threads(num_threads);
+
+	if (block_size > 0)
+		solver.set_tile_size(block_size);
+
+	solver.compute_result();
+
+	if (verifier && !solver.is_singular() && !verifier->can_verify_modular(solver.get_result()))
+		verifier->verify_factorization(solver.get_factors(), solver.get_pivots());
+
+	if (print_perf_info)
+	{
+		std::cout << "Parsing time: " << parsing_time << "ms" << std::endl;
+		std::cout << std::endl;
+		std::cout << "Tiled LU performance statistics:" << std::endl;
+		std::cout << "Setup time: " << copy_time + solver.get_setup_time() << "ms" << std::endl;
+		std::cout << "Computation time: " << solver.get_computation_time() << "ms" << std::endl;
+		std::cout << "=== TOTAL TIME: " << copy_time + solver.get_setup_time() + solver.get_computation_time() + parsing_time << "ms ===" << std::endl;
+		std::cout << "Threads used: " << solver.get_num_threads() << " (tile size " << solver.get_tile_size() << ", " << solver.get_task_count() << " tasks)" << std::endl;
+		std::cout << "Core utilisation: " << std::fixed << std::setprecision(1) << solver.get_utilisation() * 100 << "%" << std::defaultfloat << std::endl;
+	}
+
+	return solver.get_result();
+}
+
+matrix_member get_fixed_size_determinant(const CMatrix& source_matrix)
+{
+	time_value kernel_start = get_current_time();
+	matrix_member determinant = fixed_size_determinant(source_matrix);
+	time_value kernel_end = get_current_time();
+
+	if (print_perf_info)
+	{
+		std::cout << "Parsing time: " << parsing_time << "ms" << std::endl;
+		std::cout << "Fixed-size " << source_matrix.get_row_count() << "x" << source_matrix.get_row_count() << " kernel time: " << time_diff_us(kernel_end, kernel_start) << "us" << std::endl;
+		std::cout << "=== TOTAL TIME: " << parsing_time + time_diff(kernel_end, kernel_start) << "ms ===" << std::endl;
+	}
+
+	return determinant;
+}
+
+matrix_member get_symmetric_determinant(CMatrix&& source_matrix)
+{
+	const matrix_size size = source_matrix.get_row_count();
+	time_value setup_start = get_current_time();
+	CSymmetricDeterminant solver(std::move(source_matrix)); // only the packed lower triangle is kept
+	millisecond_time_difference copy_time = time_diff(get_current_time(), setup_start);
+
+	if (num_threads > 0)
+		solver.set_num_threads(num_threads);
+
+	solver.compute_result();
+
+	if (print_perf_info)
+	{
+		std::cout << "Parsing time: " << parsing_time << "ms" << std::endl;
+		std::cout << std::endl;
+		std::cout << "Symmetric (Cholesky / LDL^T) performance statistics:" << std::endl;
+		std::cout << "Setup time (packing): " << copy_time << "ms" << std::endl;
+		std::cout << "Computation time: " << solver.get_computation_time() << "ms" << std::endl;
+		std::cout << "=== TOTAL TIME: " << copy_time + solver.get_computation_time() + parsing_time << "ms ===" << std::endl;
+		std::cout << "Threads used: " << solver.get_num_threads() << std::endl;
+		std::cout << "Packed members: " << solver.get_member_count() << " (" << (unsigned long long)size * size << " in full storage)" << std::endl;
+
+		if (solver.is_positive_definite())
+			std::cout << "Positive definite, Cholesky factorization used" << std::endl;
+		else
+			std::cout << "Not positive definite, LDL^T used after " << solver.get_cholesky_steps() << " Cholesky steps (" << solver.get_two_by_two_pivot_count() << " 2x2 pivots)" << std::endl;
+	}
+
+	return solver.get_result();
+}
+
+void apply_tuning_profile(matrix_size size)
+{
+	const tuning_entry* entry = tuning_profile.find(size);
+
+	if (!entry)
+		return;
+
+	// only the default implementation can be cancelled and checkpointed, so the profile doesn't switch away from it then
+	const bool keep_default_impl = timeout_ms > 0 || !checkpoint_path.empty();
+
+	if (!keep_default_impl)
+	{
+		use_singlethread_impl = entry->engine == tuned_engine::singlethread;
+		use_tiled_impl = entry->engine == tuned_engine::tiled;
+		use_strassen_schur_impl = entry->engine == tuned_engine::strassen_schur;
+	}
+
+	if (num_threads == 0)
+		num_threads = (int)entry->threads;
+
+	if (block_size == 0)
+		block_size = (int)entry->block_size;
+
+	if (keep_default_impl && entry->engine != tuned_engine::multithreaded)
+		std::cerr << "Warning: the tuning profile prefers the " << get_tuned_engine_name(entry->engine) << " implementation, the multithreaded one is used because of --timeout / --checkpoint" << std::endl;
+
+	if (print_perf_info)
+		std::cout << "Tuning profile: " << get_tuned_engine_name(entry->engine) << ", " << entry->threads << " threads, block size " << entry->block_size << " (calibrated for size " << entry->size << ")" << std::endl << std::endl;
+}
+
+int calibrate_tuning_profile(const std::string& path)
+{
+	const std::vector<matrix_size> sizes = { 16, 32, 64, 128, 256 };
+	const unsigned int max_threads = num_threads > 0 ? (unsigned int)num_threads : std::max(std::thread::hardware_concurrency(), 1u);
+
+	CTuningProfile profile = CTuningProfile::calibrate(sizes, max_threads, &std::cout);
+	profile.save(path);
+
+	std::cout << "Tuning profile saved to \"" << path << "\"" << std::endl;
+
+	return 0;
+}
+
+matrix_member compute_determinant(CMatrix&& source_matrix)
+{
+	// small matrices are cheaper to compute than to set up any of the engines, but only the multithreaded GEM takes checkpoints
+	if (is_fixed_size_matrix(source_matrix) && checkpoint_path.empty())
+		return get_fixed_size_determinant(source_matrix);
+
+	// symmetric matrices take half the work, no matter what the tuning profile says - but LDL^T keeps no elimination log for the residual check
+	// and can't be cancelled or checkpointed like the default implementation
+	if (detect_symmetry && !engine_selected && !verify_result && timeout_ms == 0 && checkpoint_path.empty() && is_matrix_symmetric(source_matrix))
+		return get_symmetric_determinant(std::move(source_matrix));
+
+	if (!engine_selected && !tuning_profile.is_empty())
+		apply_tuning_profile(source_matrix.get_row_count());
+
+	if (use_strassen_schur_impl)
+		return get_strassen_schur_determinant(std::move(source_matrix));
+
+	if (use_tiled_impl)
+		return get_tiled_determinant(std::move(source_matrix));
+
+	CMatrix gemed_matrix = get_gemed_matrix(std::move(source_matrix));
+	matrix_member determinant = multiply_matrix_diagonal(gemed_matrix) * gemed_matrix.get_swap_coefficient();
+
+	if (verifier && !verifier->can_verify_modular(determinant))
+		verifier->verify_elimination(gemed_matrix, elimination_log);
+
+	return determinant;
+}
+
+// returns false if the verification failed, determinant is replaced by the exact one if the modular check certified it
+bool check_verification(matrix_member& determinant)
+{
+	if (!verifier->is_performed() && verifier->can_verify_modular(determinant) && verifier->verify_modular(determinant))
+		determinant = verifier->get_certified_determinant();
+
+	if (!verifier->is_performed())
+	{
+		std::cerr << "Warning: the result was not verified - only integer matrices with a small determinant can be verified with this implementation" << std::endl;
+		return true;
+	}
+
+	if (print_perf_info)
+	{
+		std::cout << std::endl;
+		std::cout << "Verification (" << verifier->get_method() << "): " << (verifier->get_passed() ? "passed" : "failed") << std::endl;
+		std::cout << "Verification time: " << verifier->get_verification_time() << "ms" << std::endl;
+		std::cout << "Verification confidence: 1 - " << std::setprecision(3) << verifier->get_error_probability() << std::endl;
+	}
+
+	if (!verifier->get_passed())
+		std::cerr << "Error: verification of the result failed (" << verifier->get_method() << ")" << std::endl;
+
+	return verifier->get_passed();
+}
+
+int exit_on_non_square_matrix(matrix_size row_count, matrix_size column_count)
+{
+	std::cerr << "Cannot compute determinant of a matrix that is not square (input matrix has " << column_count << " columns and " << row_count << " rows)" << std::endl;
+	return -1;
+}
+
 int calculate_matrix_determinant(CMatrix&& source_matrix)
 {
 	if (!is_matrix_square(source_matrix))
-	{	
-		std::cerr << "Cannot compute determinant of a matrix that is not square (input matrix has " << source_matrix.get_column_count() << " columns and " << source_matrix.get_row_count() << " rows)" << std::endl;
-		return -1;
+		return exit_on_non_square_matrix(source_matrix.get_row_count(), source_matrix.get_column_count());
+
+	if (verify_result)
+		verifier.reset(new CResultVerifier(source_matrix));
+
+	// fixed-size kernels are cheaper than hashing the matrix
+	const bool cacheable = !is_fixed_size_matrix(source_matrix);
+	time_value lookup_start = get_current_time();
+	const matrix_hash cache_key = cacheable ? hash_matrix(source_matrix) : matrix_hash();
+	matrix_member determinant;
+	const bool cached = cacheable && result_cache.find(cache_key, determinant);
+	millisecond_time_difference lookup_time = time_diff(get_current_time(), lookup_start);
+
+	if (!cached)
+		determinant = compute_determinant(std::move(source_matrix));
+	else if (print_perf_info)
+		std::cout << "Parsing time: " << parsing_time << "ms" << std::endl;
+
+	const bool verified = !verifier || check_verification(determinant);
+
+	if (cacheable && !cached && verified)
+	{
+		try
+		{
+			result_cache.store(cache_key, determinant);
+		}
+		catch (std::runtime_error& e)
+		{
+			std::cerr << "Warning: the result was not cached - " << e.what() << std::endl;
+		}
 	}
 
-	CMatrix gemed_matrix = get_gemed_matrix(std::move(source_matrix));
+	if (print_perf_info && cacheable)
+	{
+		std::cout << std::endl;
+		std::cout << "Result cache " << (cached ? "hit" : "miss") << " (key " << cache_key.to_string() << "), lookup time: " << lookup_time << "ms" << std::endl;
+		std::cout << "Result cache hits: " << result_cache.get_hit_count() << " (" << result_cache.get_disk_hit_count() << " from disk), misses: " << result_cache.get_miss_count() << std::endl;
+	}
+
+	if (print_perf_info)
+		std::cout << std::endl << "Determinant: ";
+
+	std::cout << std::setprecision(5) << determinant << std::endl;
+
+	return verified ? 0 : -1;
+}
+
+int calculate_matrix_determinant(const CMatrix& source_matrix)
+{
+	return calculate_matrix_determinant(CMatrix(source_matrix));
+}
+
+int calculate_resumed_determinant()
+{
+	CMultithreadedMatrixGem solver(load_gem_checkpoint(checkpoint_path));
+	CMatrix gemed_matrix = run_multithreaded_gem(solver);
 
 	matrix_member determinant = multiply_matrix_diagonal(gemed_matrix) * gemed_matrix.get_swap_coefficient();
 
@@ -139,9 +474,140 @@ int calculate_matrix_determinant(CMatrix&& source_matrix)
 	return 0;
 }
 
-int calculate_matrix_determinant(const CMatrix& source_matrix)
+int calculate_out_of_core_determinant(std::istream& stream)
 {
-	return calculate_matrix_determinant(CMatrix(source_matrix));
+	const char* temporary_directory = getenv("TMPDIR");
+	COutOfCoreMatrixGem solver(stream, PARSING_LINE_DELIMITER, memory_limit, temporary_directory && *temporary_directory ? temporary_directory : "/tmp");
+
+	// the matrix is only known to be square once it is parsed
+	try
+	{
+		solver.compute_result();
+	}
+	catch (non_square_matrix_exception& e)
+	{
+		return exit_on_non_square_matrix(e.get_row_count(), e.get_column_count());
+	}
+
+	if (print_perf_info)
+	{
+		std::cout << "Out-of-core gauss elimination performance statistics:" << std::endl;
+		std::cout << "Parsing and spooling time: " << solver.get_spooling_time() << "ms" << std::endl;
+		std::cout << "Computation time: " << solver.get_computation_time() << "ms" << std::endl;
+		std::cout << "Time spent waiting for disk: " << solver.get_io_wait_time() << "ms" << std::endl;
+		std::cout << "=== TOTAL TIME: " << solver.get_spooling_time() + solver.get_computation_time() << "ms ===" << std::endl;
+		std::cout << "Panels: " << solver.get_panel_count() << " of " << solver.get_panel_row_count() << " rows" << std::endl;
+		std::cout << "Bytes read: " << solver.get_bytes_read() << ", bytes written: " << solver.get_bytes_written() << std::endl;
+		std::cout << std::endl << "Determinant: ";
+	}
+
+	std::cout << std::setprecision(5) << solver.get_result() << std::endl;
+
+	return 0;
+}
+
+int calculate_streaming_determinant(std::istream& stream)
+{
+	CStreamingMatrixGem solver(stream, PARSING_LINE_DELIMITER);
+
+	if (num_threads > 0)
+		solver.set_num_threads(num_threads);
+
+	try
+	{
+		solver.compute_result();
+	}
+	catch (non_square_matrix_exception& e)
+	{
+		return exit_on_non_square_matrix(e.get_row_count(), e.get_column_count());
+	}
+
+	if (print_perf_info)
+	{
+		std::cout << "Streaming gauss elimination performance statistics:" << std::endl;
+		std::cout << "Parsing time (overlapped with elimination): " << solver.get_parsing_time() << "ms" << std::endl;
+		std::cout << "Time spent waiting for parsed rows: " << solver.get_input_wait_time() << "ms" << std::endl;
+		std::cout << "=== TOTAL TIME: " << solver.get_computation_time() << "ms ===" << std::endl;
+		std::cout << "Threads used: " << solver.get_num_threads() << " and a parsing thread" << std::endl;
+		std::cout << std::endl << "Determinant: ";
+	}
+
+	std::cout << std::setprecision(5) << solver.get_result() << std::endl;
+
+	return 0;
+}
+
+int calculate_distributed_determinant(std::istream& stream)
+{
+	CDistributedMatrixGem solver(stream, PARSING_LINE_DELIMITER, distributed_workers);
+
+	if (block_size > 0)
+		solver.set_block_size(block_size);
+
+	// rows are dealt while parsing, the matrix is only known to be square at the end
+	try
+	{
+		solver.compute_result();
+	}
+	catch (non_square_matrix_exception& e)
+	{
+		return exit_on_non_square_matrix(e.get_row_count(), e.get_column_count());
+	}
+
+	if (print_perf_info)
+	{
+		std::cout << "Distributed gauss elimination performance statistics:" << std::endl;
+		std::cout << "Setup time (connecting, parsing and distributing rows): " << solver.get_setup_time() << "ms" << std::endl;
+		std::cout << "Computation time: " << solver.get_computation_time() << "ms" << std::endl;
+		std::cout << "Time spent waiting for workers: " << solver.get_communication_wait_time() << "ms" << std::endl;
+		std::cout << "Cleanup time: " << solver.get_cleanup_time() << "ms" << std::endl;
+		std::cout << "=== TOTAL TIME: " << solver.get_setup_time() + solver.get_computation_time() + solver.get_cleanup_time() << "ms ===" << std::endl;
+		std::cout << "Workers used: " << solver.get_worker_count() << " (block size " << solver.get_block_size() << ")" << std::endl;
+		std::cout << "Bytes sent: " << solver.get_bytes_sent() << ", bytes received: " << solver.get_bytes_received() << std::endl;
+		std::cout << std::endl << "Determinant: ";
+	}
+
+	std::cout << std::setprecision(5) << solver.get_result() << std::endl;
+
+	return 0;
+}
+
+// parses sizes like 512, 64K, 16M or 2G
+size_t parse_size(const char* str)
+{
+	char* suffix = nullptr;
+	const unsigned long long value = strtoull(str, &suffix, 10);
+
+	if (suffix == str)
+		return 0;
+
+	switch (toupper(*suffix))
+	{
+	case '\0': return (size_t)value;
+	case 'K': return (size_t)(value << 10);
+	case 'M': return (size_t)(value << 20);
+	case 'G': return (size_t)(value << 30);
+	default: return 0;
+	}
+}
+
+std::vector<std::string> split_list(const std::string& list)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(list);
+	std::string item;
+
+	while (std::getline(stream, item, ','))
+		if (!item.empty())
+			items.push_back(item);
+
+	return items;
+}
+
+// the default multithreaded implementation is the only one which can be cancelled and checkpointed
+bool is_default_impl_selected()
+{
+	return !use_singlethread_impl && !use_strassen_schur_impl && !use_tiled_impl && !use_streaming_impl && memory_limit == 0 && distributed_workers.empty();
 }
 
 int exit_on_invalid_args()
@@ -156,6 +622,24 @@ int main(int argc, char** argv)
 	 * args:
 	 *  -s use singlethread impl
 	 *  -t [#] use # threads
+	 *  -w use strassen-winograd schur complement impl
+	 *  -b [#] use # as block size
+	 *  -d [list] use distributed impl with workers in list
+	 *  -l [address] run as distributed worker
+	 *  --tiled use tiled lu impl
+	 *  --no-symmetric don't use symmetric impl for symmetric matrices
+	 *  --stream use streaming impl
+	 *  --mem-limit [size] use out-of-core impl with memory limit size
+	 *  --timeout [ms] cancel multithreaded computation after ms (default impl only)
+	 *  --checkpoint [path] save multithreaded computation state to path (default impl only)
+	 *  --checkpoint-interval [s] minimal time between checkpoints
+	 *  --resume continue from checkpoint
+	 *  --verify check the result
+	 *  --calibrate [profile] measure engines and save tuning profile
+	 *  --profile [profile] choose engine by tuning profile
+	 *  --cache-dir [dir] store results in dir
+	 *  --cache-size [size] limit size of the cache dir
+	 *  --serve [address] run as determinant service
 	 *  -p show perf info
 	 *  -h, -help show help
 	 *  -m direct input
@@ -186,6 +670,181 @@ int main(int argc, char** argv)
 			return 0;
 		}
 
+		if (strcmp("--tiled", curr_arg) == 0)
+		{
+			use_tiled_impl = true;
+			engine_selected = true;
+			continue;
+		}
+
+		if (strcmp("--no-symmetric", curr_arg) == 0)
+		{
+			detect_symmetry = false;
+			continue;
+		}
+
+		if (strcmp("--stream", curr_arg) == 0)
+		{
+			use_streaming_impl = true;
+			continue;
+		}
+
+		if (strcmp("--mem-limit", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			memory_limit = parse_size(argv[i]);
+
+			if (memory_limit == 0)
+				return exit_on_invalid_args();
+
+			continue;
+		}
+
+		if (strcmp("--timeout", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			timeout_ms = atoll(argv[i]);
+
+			if (timeout_ms <= 0)
+				return exit_on_invalid_args();
+
+			continue;
+		}
+
+		if (strcmp("--checkpoint", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			checkpoint_path = argv[i];
+			continue;
+		}
+
+		if (strcmp("--checkpoint-interval", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			checkpoint_interval_s = atoll(argv[i]);
+
+			if (checkpoint_interval_s < 0)
+				return exit_on_invalid_args();
+
+			continue;
+		}
+
+		if (strcmp("--resume", curr_arg) == 0)
+		{
+			resume_from_checkpoint = true;
+			continue;
+		}
+
+		if (strcmp("--verify", curr_arg) == 0)
+		{
+			verify_result = true;
+			continue;
+		}
+
+		if (strcmp("--calibrate", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			try
+			{
+				return calibrate_tuning_profile(argv[i]);
+			}
+			catch (std::runtime_error& e)
+			{
+				std::cerr << "Error: " << e.what() << std::endl;
+				return -3;
+			}
+		}
+
+		if (strcmp("--profile", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			try
+			{
+				tuning_profile = CTuningProfile::load(argv[i]);
+			}
+			catch (std::runtime_error& e)
+			{
+				std::cerr << "Error: " << e.what() << std::endl;
+				return -3;
+			}
+			continue;
+		}
+
+		if (strcmp("--cache-dir", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			cache_directory = argv[i];
+			continue;
+		}
+
+		if (strcmp("--cache-size", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			cache_disk_limit = parse_size(argv[i]);
+
+			if (cache_disk_limit == 0)
+				return exit_on_invalid_args();
+
+			continue;
+		}
+
+		if (strcmp("--serve", curr_arg) == 0)
+		{
+			i++;
+
+			if (argv[i] == nullptr)
+				return exit_on_invalid_args();
+
+			try
+			{
+				if (!cache_directory.empty())
+					result_cache.set_directory(cache_directory, cache_disk_limit);
+
+				CDeterminantServer server(argv[i]);
+				server.set_large_matrix_threads(num_threads);
+				server.set_result_cache(&result_cache);
+				server.run();
+			}
+			catch (std::runtime_error& e)
+			{
+				std::cerr << "Error: " << e.what() << std::endl;
+				return -3;
+			}
+			return 0;
+		}
+
 		if (*curr_arg == '-')
 		{
 			curr_arg++;
@@ -200,6 +859,7 @@ int main(int argc, char** argv)
 			{
 			case 's':
 				use_singlethread_impl = true;
+				engine_selected = true;
 				break;
 
 			case 'p':
@@ -225,6 +885,55 @@ int main(int argc, char** argv)
 				}
 				break;
 
+			case 'w':
+				use_strassen_schur_impl = true;
+				engine_selected = true;
+				break;
+
+			case 'b':
+				i++;
+
+				if (argv[i] == nullptr)
+					return exit_on_invalid_args();
+
+				block_size = atoi(argv[i]);
+
+				if (block_size <= 0)
+				{
+					block_size = 0;
+					std::cerr << "invalid block size specified, using default instead" << std::endl;
+				}
+				break;
+
+			case 'd':
+				i++;
+
+				if (argv[i] == nullptr)
+					return exit_on_invalid_args();
+
+				distributed_workers = split_list(argv[i]);
+
+				if (distributed_workers.empty())
+					return exit_on_invalid_args();
+				break;
+
+			case 'l':
+				i++;
+
+				if (argv[i] == nullptr)
+					return exit_on_invalid_args();
+
+				try
+				{
+					serve_distributed_gem_worker(argv[i]);
+				}
+				catch (std::runtime_error& e)
+				{
+					std::cerr << "Error: " << e.what() << std::endl;
+					return -3;
+				}
+				return 0;
+
 			case 'm':
 				direct_input = true;
 				break;
@@ -250,13 +959,46 @@ int main(int argc, char** argv)
 			user_arg.append(" ");
 	}
 
-	if (user_arg.empty())
+	if (resume_from_checkpoint && checkpoint_path.empty())
+		return exit_on_invalid_args();
+
+	if ((timeout_ms > 0 || !checkpoint_path.empty()) && !is_default_impl_selected())
+		return exit_on_invalid_args();
+
+	// INPUT is not needed when there is a checkpoint to continue from
+	const bool resuming = resume_from_checkpoint && std::ifstream(checkpoint_path).good();
+
+	if (user_arg.empty() && !resuming)
 		return exit_on_invalid_args();
 
 	CMatrix (*parsing_fun)(const std::string&) = &(direct_input ? parse_matrix_from_string : parse_matrix_from_file);
 
 	try
 	{
+		if (!cache_directory.empty())
+			result_cache.set_directory(cache_directory, cache_disk_limit);
+
+		if (verify_result && (memory_limit > 0 || use_streaming_impl || !distributed_workers.empty() || resuming))
+			std::cerr << "Warning: the result will not be verified - the original matrix is not kept in memory" << std::endl;
+
+		if (resuming)
+			return calculate_resumed_determinant();
+
+		// these implementations parse the input on their own, the whole matrix is never held in memory
+		if (memory_limit > 0 || use_streaming_impl || !distributed_workers.empty())
+		{
+			int (*calculation_fun)(std::istream&) = memory_limit > 0 ? calculate_out_of_core_determinant : use_streaming_impl ? calculate_streaming_determinant : calculate_distributed_determinant;
+
+			if (direct_input)
+			{
+				std::stringstream stream(user_arg);
+				return calculation_fun(stream);
+			}
+
+			CInputFile file(user_arg);
+			return calculation_fun(file.get_stream());
+		}
+
 		time_value parsing_start = get_current_time();
 		CMatrix parsed_matrix = parsing_fun(user_arg);
 		parsing_time = time_diff(get_current_time(), parsing_start);